@@ -0,0 +1,181 @@
+/**
+ * Throughput benchmarks for xtea.hpp, single-threaded unless stated otherwise.
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O3 -pthread -I. bench/xtea_bench.cpp -o xtea_bench && ./xtea_bench [section]
+ * Without a section every one runs. Sections:
+ *   kernels  bitsliced engine against the lane kernels by batch size
+ *   scalar   portable kernel, one block at a time or batched, on aligned and unaligned
+ *            buffers; build at -O2 and -O3 to see what auto-vectorization adds
+ *   xxtea    XXTEA, one message or a batch in lanes, against XTEA-ECB by message size
+ *   policy   std::execution::par_unseq and the thread pool against one thread, on all
+ *            cores; needs -std=c++17 -DXTEA_WITH_EXECUTION and, with libstdc++, -ltbb
+ */
+#include "xtea.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+using namespace XTea;
+
+/**
+ * Seconds each measurement runs for
+ */
+static const double MIN_TIME = 0.2;
+
+/**
+ * Calls fn, in growing rounds so the clock is read rarely, until MIN_TIME has
+ * passed and returns the throughput in MB/s for bytes processed per call
+ */
+template<class Fn>
+static double Throughput(size_t bytes, const Fn& fn) {
+    typedef std::chrono::steady_clock Clock;
+    fn();
+    size_t calls = 0;
+    double elapsed = 0;
+    const Clock::time_point start = Clock::now();
+    for (size_t n = 1; elapsed < MIN_TIME; n *= 2) {
+        for (size_t i = 0; i < n; i++) fn();
+        calls += n;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return (double)bytes * (double)calls / elapsed / 1e6;
+}
+
+static std::vector<uchar> Pattern(size_t size) {
+    std::vector<uchar> data(size);
+    for (size_t i = 0; i < size; i++) data[i] = (uchar)(i * 31 + 7);
+    return data;
+}
+
+static void PrintRate(double rate) {
+    if (rate < 0) printf("%9s", "-");
+    else printf("%9.0f", rate);
+}
+
+static const uchar KEY[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+/**
+ * Bitsliced engine (64-bit planes, and 256-bit planes on AVX2) against the
+ * lane-wise kernels, 32 rounds, for growing batches of blocks
+ */
+static void BenchKernels() {
+    printf("kernels: ECB encryption in MB/s, 32 rounds\n");
+    printf("%15s%9s%9s%9s%9s%9s%9s\n", "batch (blocks)", "scalar", "bits64", "bits256", "sse2", "avx2", "avx512");
+    const Context ctx(KEY);
+    const size_t batches[] = { 256, 1024, 16384, 262144 };
+    for (size_t n_blocks : batches) {
+        const size_t size = BLOCK_SIZE * n_blocks;
+        const std::vector<uchar> src = Pattern(size);
+        std::vector<uchar> dst(size);
+        const auto kernel = [&](Kernel k) {
+            if (!SetKernel(k)) return -1.0;
+            return Throughput(size, [&] { Encrypt(src.data(), dst.data(), size, ctx); });
+        };
+        printf("%15zu", n_blocks);
+        PrintRate(kernel(Kernel::Scalar));
+        PrintRate(Throughput(size, [&] {
+            Detail::EncipherData(src.data(), dst.data(), size, ctx.EncipherSchedule(), Detail::EncipherBulkBitsliced);
+        }));
+        // The bitsliced kernel uses 256-bit planes when AVX2 is there, 64-bit ones otherwise
+        PrintRate(SetKernel(Kernel::Avx2) ? kernel(Kernel::Bitsliced) : -1.0);
+        PrintRate(kernel(Kernel::Sse2));
+        PrintRate(kernel(Kernel::Avx2));
+        PrintRate(kernel(Kernel::Avx512));
+        printf("\n");
+    }
+    SetKernel(Kernel::Auto);
+}
+
+/**
+ * Portable kernel: SCALAR_BATCH blocks per round loop against one block at a
+ * time, with the words loaded through memcpy from aligned and unaligned buffers
+ */
+static void BenchScalar() {
+    printf("scalar: ECB encryption in MB/s, 32 rounds, 1 MiB\n");
+    printf("%15s%12s%12s\n", "buffer", "one block", "batched");
+    const Context ctx(KEY);
+    const size_t size = 1 << 20;
+    const std::vector<uchar> src = Pattern(size + 1);
+    std::vector<uchar> dst(size + 1);
+    const Detail::BulkFn none = [](const uchar*, uchar*, size_t, const Detail::Schedule&) -> size_t { return 0; };
+    const Detail::Schedule s = ctx.EncipherSchedule();
+    for (size_t offset = 0; offset < 2; offset++) {
+        const uchar* in = src.data() + offset;
+        uchar* out = dst.data() + offset;
+        printf("%15s", offset ? "unaligned" : "aligned");
+        printf("%12.0f", Throughput(size, [&] { Detail::EncipherData(in, out, size, s, none); }));
+        printf("%12.0f\n", Throughput(size, [&] { Detail::EncipherData(in, out, size, s, Detail::EncipherBulkScalar<0>); }));
+    }
+}
+
+/**
+ * XXTEA over each message as one block, alone and XXTEA_BATCH at a time in the
+ * lanes of the active kernel, against XTEA-ECB over the same bytes
+ */
+static void BenchXxtea() {
+    const size_t XXTEA_BATCH = 64;
+    printf("xxtea: encryption in MB/s, %s kernel, batches of %zu messages\n",
+           ActiveKernel() == Kernel::Avx512 ? "avx512" : ActiveKernel() == Kernel::Avx2 ? "avx2" :
+           ActiveKernel() == Kernel::Sse2 ? "sse2" : "scalar", XXTEA_BATCH);
+    printf("%15s%12s%12s%12s\n", "message", "xtea-ecb", "xxtea", "xxtea batch");
+    const Context ctx(KEY);
+    const XxteaContext xxtea(KEY);
+    const size_t sizes[] = { 64, 1024, 65536 };
+    for (size_t size : sizes) {
+        std::vector<uchar> data = Pattern(size * XXTEA_BATCH);
+        std::vector<uchar*> messages(XXTEA_BATCH);
+        for (size_t m = 0; m < XXTEA_BATCH; m++) messages[m] = data.data() + size * m;
+        printf("%13zuB ", size);
+        printf("%12.0f", Throughput(size, [&] { Encrypt(data.data(), data.data(), size, ctx); }));
+        printf("%12.0f", Throughput(size, [&] { Encrypt(data.data(), size, xxtea); }));
+        printf("%12.0f\n", Throughput(size * XXTEA_BATCH, [&] { EncryptBatch(messages.data(), XXTEA_BATCH, size, xxtea); }));
+    }
+}
+
+/**
+ * Execution policy overloads against the serial call and the thread pool
+ * of this header, over a buffer much larger than the caches
+ */
+static void BenchPolicy() {
+#ifdef XTEA_HAS_EXECUTION
+    const size_t size = (size_t)256 << 20;
+    printf("policy: ECB encryption in MB/s, 32 rounds, 256 MiB, %u hardware threads\n", std::thread::hardware_concurrency());
+    printf("%12s%12s%12s\n", "serial", "par_unseq", "pool");
+    const Context ctx(KEY);
+    std::vector<uchar> data = Pattern(size);
+    printf("%12.0f", Throughput(size, [&] { Encrypt(data.data(), data.data(), size, ctx, 1u); }));
+    printf("%12.0f", Throughput(size, [&] { Encrypt(std::execution::par_unseq, data.data(), data.data(), size, ctx); }));
+    printf("%12.0f\n", Throughput(size, [&] { Encrypt(data.data(), data.data(), size, ctx, 0u); }));
+#else
+    printf("policy: not built, needs -std=c++17 -DXTEA_WITH_EXECUTION\n");
+#endif
+}
+
+struct Section {
+    const char* name;
+    void (*run)();
+};
+
+static const Section SECTIONS[] = {
+    { "kernels", BenchKernels },
+    { "scalar", BenchScalar },
+    { "xxtea", BenchXxtea },
+    { "policy", BenchPolicy },
+};
+
+int main(int argc, char** argv) {
+    bool found = false;
+    for (const Section& section : SECTIONS) {
+        if (argc > 1 && strcmp(argv[1], section.name) != 0) continue;
+        section.run();
+        found = true;
+    }
+    if (!found) {
+        printf("Unknown section %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * The deprecated USE_TEA_INSTEAD_OF_XTEA define must keep working: it makes TEA the
+ * algorithm of the raw-key functions and of contexts which are not given one.
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -pthread -I. tests/legacy_tea_test.cpp -o legacy_tea_test && ./legacy_tea_test
+ */
+#define USE_TEA_INSTEAD_OF_XTEA
+#include "xtea.hpp"
+
+#include <stdio.h>
+
+#include <vector>
+
+using namespace XTea;
+
+int main() {
+    int failures = 0;
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 3 + 1);
+    uint32_t k[4];
+    memcpy(k, key, 16);
+
+    uint32_t v[2] = { 0, 0 }, w[2] = { 0, 0 };
+    EncipherBlock(v, k, 32);
+    Tea::EncipherBlock(w, k, 32);
+    if (v[0] != w[0] || v[1] != w[1]) failures++;
+    DecipherBlock(v, k, 32);
+    if (v[0] != 0 || v[1] != 0) failures++;
+
+    const size_t size = 8 * 100;
+    std::vector<uchar> plain(size), data, ref;
+    for (size_t i = 0; i < size; i++) plain[i] = (uchar)(i * 7);
+    data = plain;
+    ref = plain;
+    Encrypt(data.data(), size, key);
+    Encrypt(ref.data(), ref.data(), size, Context(key, 32, ByteOrder::Little, Algorithm::Tea));
+    if (data != ref) failures++;
+    Decrypt(data.data(), data.data(), size, Context(key));
+    if (data != plain) failures++;
+
+    if (failures != 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All tests passed\n");
+    return 0;
+}
@@ -0,0 +1,669 @@
+/**
+ * Tests for xtea.hpp: known answers, kernel equivalence and the APIs built on the kernels.
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -pthread -I. tests/xtea_test.cpp -o xtea_test && ./xtea_test
+ * Built with -std=c++20 it also covers the std::span overloads.
+ * Exits with a non-zero status if any check fails.
+ */
+#include "xtea.hpp"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+using namespace XTea;
+
+static int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+static const Kernel KERNELS[] = { Kernel::Scalar, Kernel::Sse2, Kernel::Avx2, Kernel::Avx512, Kernel::Bitsliced };
+
+static std::vector<uchar> Pattern(size_t size, uchar seed) {
+    std::vector<uchar> data(size);
+    for (size_t i = 0; i < size; i++) data[i] = (uchar)(i * 31 + seed);
+    return data;
+}
+
+/**
+ * XTEA reference vector: key 000102..0f, plaintext "ABCDEFGH", 32 cycles,
+ * words read big-endian
+ */
+static void TestXteaKnownAnswer() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)i;
+    const uchar plain[8] = { 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48 };
+    const uchar cipher[8] = { 0x49, 0x7d, 0xf3, 0xd0, 0x72, 0x61, 0x2c, 0xb5 };
+
+    const uint32_t k[4] = { 0x00010203, 0x04050607, 0x08090a0b, 0x0c0d0e0f };
+    uint32_t v[2] = { 0x41424344, 0x45464748 };
+    EncipherBlock(v, k, 32);
+    CHECK(v[0] == 0x497df3d0 && v[1] == 0x72612cb5);
+    DecipherBlock(v, k, 32);
+    CHECK(v[0] == 0x41424344 && v[1] == 0x45464748);
+
+    uchar data[8];
+    memcpy(data, plain, 8);
+    Encrypt(data, 8, key, 32, ByteOrder::Big);
+    CHECK(memcmp(data, cipher, 8) == 0);
+    Decrypt(data, 8, key, 32, ByteOrder::Big);
+    CHECK(memcmp(data, plain, 8) == 0);
+}
+
+/**
+ * TEA reference vector: all-zero key and plaintext, 32 cycles
+ */
+static void TestTeaKnownAnswer() {
+    const uint32_t k[4] = { 0, 0, 0, 0 };
+    uint32_t v[2] = { 0, 0 };
+    Tea::EncipherBlock(v, k);
+    CHECK(v[0] == 0x41ea3a0a && v[1] == 0x94baa940);
+    Tea::DecipherBlock(v, k);
+    CHECK(v[0] == 0 && v[1] == 0);
+}
+
+/**
+ * Every kernel must produce the output of the scalar one, for both algorithms,
+ * both byte orders and sizes which leave a partial batch to the scalar tail
+ */
+static void TestKernelEquivalence() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 7 + 1);
+    const Algorithm algorithms[] = { Algorithm::Xtea, Algorithm::Tea };
+    const ByteOrder orders[] = { ByteOrder::Little, ByteOrder::Big };
+    const size_t sizes[] = { 8, 8 * 15, 8 * 1031 };
+    for (Algorithm algorithm : algorithms) {
+        for (ByteOrder order : orders) {
+            const Context ctx(key, 32, order, algorithm);
+            for (size_t size : sizes) {
+                const std::vector<uchar> plain = Pattern(size, 5);
+                SetKernel(Kernel::Scalar);
+                std::vector<uchar> ecb = plain, ctr = plain;
+                Encrypt(ecb.data(), ecb.data(), size, ctx);
+                EncryptCtr(ctr.data(), size - 3, ctx, 1234, 3);
+                for (Kernel kernel : KERNELS) {
+                    if (!SetKernel(kernel)) continue;
+                    std::vector<uchar> data = plain;
+                    Encrypt(data.data(), data.data(), size, ctx);
+                    CHECK(data == ecb);
+                    Decrypt(data.data(), data.data(), size, ctx);
+                    CHECK(data == plain);
+                    data = plain;
+                    EncryptCtr(data.data(), size - 3, ctx, 1234, 3);
+                    CHECK(data == ctr);
+                }
+            }
+        }
+    }
+    SetKernel(Kernel::Auto);
+}
+
+/**
+ * CBC round trips, including an empty buffer and buffers split across threads
+ */
+static void TestUnrolledRounds() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 5 + 3);
+    const ByteOrder orders[] = { ByteOrder::Little, ByteOrder::Big };
+    const size_t sizes[] = { 8, 8 * 15, 8 * 1031 };
+    for (ByteOrder order : orders) {
+        for (size_t size : sizes) {
+            const std::vector<uchar> plain = Pattern(size, 9);
+            std::vector<uchar> expected32 = plain, expected64 = plain;
+            Encrypt(expected32.data(), size, key, 32, order);
+            Encrypt(expected64.data(), size, key, 64, order);
+            for (Kernel kernel : KERNELS) {
+                if (!SetKernel(kernel)) continue;
+                std::vector<uchar> data = plain;
+                Encrypt<32>(data.data(), size, key, order);
+                CHECK(data == expected32);
+                Decrypt<32>(data.data(), size, key, order);
+                CHECK(data == plain);
+                Encrypt<64>(data.data(), size, key, order);
+                CHECK(data == expected64);
+                Decrypt<64>(data.data(), size, key, order);
+                CHECK(data == plain);
+            }
+        }
+    }
+    SetKernel(Kernel::Auto);
+}
+
+static void TestCbc() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 5 + 3);
+    const uchar iv[BLOCK_SIZE] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    const Context ctx(key);
+    const size_t sizes[] = { 0, 8, 8 * 3, 8 * 70001 };
+    for (size_t size : sizes) {
+        const std::vector<uchar> plain = Pattern(size, 11);
+        std::vector<uchar> data = plain;
+        EncryptCbc(data.data(), size, ctx, iv);
+        std::vector<uchar> serial = data;
+        DecryptCbc(serial.data(), size, ctx, iv);
+        CHECK(serial == plain);
+        DecryptCbc(data.data(), size, ctx, iv, 0u);
+        CHECK(data == plain);
+    }
+}
+
+/**
+ * CBC with ciphertext stealing round trips for every short size, where only the
+ * stolen blocks are chained, and for sizes with a bulk part
+ */
+static void TestCbcMultiBuffer() {
+    const uchar iv[BLOCK_SIZE] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    const size_t n_jobs = 3 * CbcMultiBuffer::LANES + 5;
+    const Algorithm algorithms[] = { Algorithm::Xtea, Algorithm::Tea };
+    for (Algorithm algorithm : algorithms) {
+        for (Kernel kernel : KERNELS) {
+            if (!SetKernel(kernel)) continue;
+            std::vector<std::vector<uchar> > keys(n_jobs), data(n_jobs), expected(n_jobs);
+            std::vector<CbcJob> jobs(n_jobs);
+            for (size_t j = 0; j < n_jobs; j++) {
+                keys[j] = Pattern(16, (uchar)(j + 1));
+                data[j] = Pattern(BLOCK_SIZE * ((j * 7) % 23), (uchar)j);
+                expected[j] = data[j];
+                EncryptCbc(expected[j].data(), expected[j].size(), Context(keys[j].data(), 32, ByteOrder::Little, algorithm), iv);
+                jobs[j].data = data[j].data();
+                jobs[j].size = data[j].size();
+                jobs[j].key = keys[j].data();
+                memcpy(jobs[j].iv, iv, BLOCK_SIZE);
+                jobs[j].user = nullptr;
+            }
+            CbcMultiBuffer scheduler(32, algorithm);
+            size_t n_done = 0;
+            for (size_t j = 0; j < n_jobs; j++) {
+                if (scheduler.Submit(&jobs[j])) n_done++;
+            }
+            while (scheduler.Flush()) n_done++;
+            CHECK(n_done == n_jobs);
+            for (size_t j = 0; j < n_jobs; j++) {
+                CHECK(data[j] == expected[j]);
+                if (!expected[j].empty()) CHECK(std::equal(jobs[j].iv, jobs[j].iv + BLOCK_SIZE, expected[j].end() - BLOCK_SIZE));
+            }
+        }
+    }
+    SetKernel(Kernel::Auto);
+}
+
+static void TestCbcCs3() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 9 + 2);
+    const uchar iv[BLOCK_SIZE] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    const Context ctx(key);
+    std::vector<size_t> sizes;
+    for (size_t size = 0; size <= 4 * BLOCK_SIZE; size++) sizes.push_back(size);
+    sizes.push_back(8 * 70001 + 5);
+    for (size_t size : sizes) {
+        const std::vector<uchar> plain = Pattern(size + 1, 13);
+        std::vector<uchar> data = plain;
+        const bool valid = size >= BLOCK_SIZE;
+        CHECK(EncryptCbcCs3(data.data(), size, ctx, iv) == valid);
+        CHECK(data[size] == plain[size]);
+        if (valid && size > BLOCK_SIZE) CHECK(data != plain);
+        CHECK(DecryptCbcCs3(data.data(), size, ctx, iv, 0u) == valid);
+        CHECK(data == plain);
+    }
+}
+
+/**
+ * Out-of-place calls on sizes which are not a multiple of the block size only touch
+ * the whole blocks; buffers have the exact size so that a sanitizer catches overruns.
+ * The legacy in-place functions still round a partial last block up
+ */
+static void TestPartialBlocks() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 11 + 4);
+    const Context ctx(key), to(key, 16);
+    const size_t size = 8 * 70001 + 5, whole = size - 5;
+    const std::vector<uchar> plain = Pattern(size, 3);
+    std::vector<uchar> ref = plain;
+    Encrypt(ref.data(), ref.data(), whole, ctx);
+
+    std::vector<uchar> out(size, 0xee);
+    Encrypt(plain.data(), out.data(), size, ctx);
+    CHECK(memcmp(out.data(), ref.data(), whole) == 0 && out[whole] == 0xee && out[size - 1] == 0xee);
+    std::fill(out.begin(), out.end(), 0xee);
+    Encrypt(plain.data(), out.data(), size, ctx, 0u);
+    CHECK(memcmp(out.data(), ref.data(), whole) == 0 && out[whole] == 0xee && out[size - 1] == 0xee);
+    std::fill(out.begin(), out.end(), 0xee);
+    Encrypt(plain.data(), out.data(), size, key);
+    CHECK(memcmp(out.data(), ref.data(), whole) == 0 && out[whole] == 0xee && out[size - 1] == 0xee);
+
+    std::vector<uchar> back(size, 0xee);
+    Decrypt(out.data(), back.data(), size, ctx, ThreadExecutor(3));
+    CHECK(memcmp(back.data(), plain.data(), whole) == 0 && back[whole] == 0xee);
+    std::fill(back.begin(), back.end(), 0xee);
+    Decrypt(out.data(), back.data(), size, key);
+    CHECK(memcmp(back.data(), plain.data(), whole) == 0 && back[whole] == 0xee);
+    Reencrypt(out.data(), back.data(), size, ctx, to, 0u);
+    CHECK(back[whole] == 0xee);
+
+    std::vector<uchar> partial(plain.begin(), plain.begin() + 13);
+    Encrypt(partial.data(), 13, key);
+    CHECK(memcmp(partial.data(), ref.data(), 8) == 0 && memcmp(partial.data() + 8, plain.data() + 8, 5) == 0);
+    Decrypt(partial.data(), 13, key);
+    CHECK(memcmp(partial.data(), plain.data(), 13) == 0);
+    Encrypt(partial.data(), 13, ctx);
+    CHECK(memcmp(partial.data(), ref.data(), 8) == 0 && memcmp(partial.data() + 8, plain.data() + 8, 5) == 0);
+    Decrypt(partial.data(), 13, ctx);
+    CHECK(memcmp(partial.data(), plain.data(), 13) == 0);
+    Encrypt<32>(partial.data(), 13, key);
+    CHECK(memcmp(partial.data(), ref.data(), 8) == 0 && memcmp(partial.data() + 8, plain.data() + 8, 5) == 0);
+    Decrypt<32>(partial.data(), 13, key);
+    CHECK(memcmp(partial.data(), plain.data(), 13) == 0);
+}
+
+static void TestTail() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 3 + 9);
+    const Context ctx(key);
+    const Tail tails[] = { Tail::Pkcs7, Tail::Zero, Tail::Stealing };
+    std::vector<size_t> sizes;
+    for (size_t size = 0; size <= 41; size++) sizes.push_back(size);
+    sizes.push_back(8 * 1031 + 5);
+    for (Tail tail : tails) {
+        for (size_t size : sizes) {
+            const std::vector<uchar> plain = Pattern(size, 17);
+            const size_t encrypted_size = EncryptedSize(size, tail);
+            std::vector<uchar> ref = plain;
+            ref.resize(encrypted_size > size ? encrypted_size : size);
+            Encrypt(ref.data(), ref.data(), size, ctx);
+            std::vector<uchar> out(encrypted_size + 1, 0xee);
+            if (tail == Tail::Stealing && size < BLOCK_SIZE) {
+                CHECK(!Encrypt(plain.data(), out.data(), size, ctx, tail));
+                CHECK(out[0] == 0xee);
+                continue;
+            }
+            CHECK(Encrypt(plain.data(), out.data(), size, ctx, tail));
+            CHECK(out[encrypted_size] == 0xee);
+            // Every block before the last two is plain ECB
+            const size_t ecb = size >= 2 * BLOCK_SIZE ? (size / BLOCK_SIZE - 1) * BLOCK_SIZE : 0;
+            CHECK(std::equal(out.begin(), out.begin() + ecb, ref.begin()));
+            if (tail == Tail::Stealing && size % BLOCK_SIZE == 0) CHECK(std::equal(out.begin(), out.begin() + size, ref.begin()));
+            if (tail == Tail::Pkcs7) CHECK(encrypted_size % BLOCK_SIZE == 0 && encrypted_size > size);
+            if (tail == Tail::Zero) CHECK(encrypted_size % BLOCK_SIZE == 0 && encrypted_size - size < BLOCK_SIZE);
+
+            std::vector<uchar> back(encrypted_size, 0xee);
+            size_t plain_size = 0;
+            CHECK(Decrypt(out.data(), back.data(), encrypted_size, ctx, tail, plain_size));
+            CHECK(plain_size == (tail == Tail::Zero ? encrypted_size : size));
+            CHECK(std::equal(plain.begin(), plain.end(), back.begin()));
+            for (size_t i = size; i < plain_size; i++) CHECK(back[i] == 0);
+
+            // In place, with room for the padding
+            std::vector<uchar> data = plain;
+            data.resize(encrypted_size);
+            CHECK(Encrypt(data.data(), data.data(), size, ctx, tail));
+            CHECK(std::equal(data.begin(), data.end(), out.begin()));
+            CHECK(Decrypt(data.data(), data.data(), encrypted_size, ctx, tail, plain_size));
+            CHECK(std::equal(plain.begin(), plain.end(), data.begin()));
+        }
+    }
+
+    // Malformed PKCS#7 padding and sizes
+    const uchar bad_blocks[][BLOCK_SIZE] = {
+        { 1, 2, 3, 4, 5, 6, 7, 0 },
+        { 1, 2, 3, 4, 5, 6, 7, 9 },
+        { 1, 2, 3, 4, 5, 3, 2, 3 },
+        { 1, 2, 3, 4, 5, 8, 8, 8 },
+    };
+    for (const uchar* block : bad_blocks) {
+        std::vector<uchar> data(block, block + BLOCK_SIZE);
+        Encrypt(data.data(), data.data(), BLOCK_SIZE, ctx);
+        size_t plain_size = 1234;
+        CHECK(!Decrypt(data.data(), data.data(), BLOCK_SIZE, ctx, Tail::Pkcs7, plain_size));
+    }
+    std::vector<uchar> data(2 * BLOCK_SIZE, 0);
+    size_t plain_size = 0;
+    CHECK(!Decrypt(data.data(), data.data(), 0, ctx, Tail::Pkcs7, plain_size));
+    CHECK(!Decrypt(data.data(), data.data(), BLOCK_SIZE + 3, ctx, Tail::Pkcs7, plain_size));
+    CHECK(!Decrypt(data.data(), data.data(), BLOCK_SIZE + 3, ctx, Tail::Zero, plain_size));
+    CHECK(!Decrypt(data.data(), data.data(), BLOCK_SIZE - 1, ctx, Tail::Stealing, plain_size));
+}
+
+#ifdef XTEA_HAS_MMAP
+static bool WriteFile(const char* path, const std::vector<uchar>& data) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    const bool written = data.empty() || fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && written;
+}
+
+static std::vector<uchar> ReadFile(const char* path) {
+    std::vector<uchar> data;
+    FILE* file = fopen(path, "rb");
+    if (!file) return data;
+    uchar buffer[4096];
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) != 0;) data.insert(data.end(), buffer, buffer + n);
+    fclose(file);
+    return data;
+}
+
+static void TestFile() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 15 + 1);
+    const Context ctx(key);
+    char path[] = "/tmp/xtea_test_XXXXXX";
+    const int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    close(fd);
+
+    const size_t size = 8 * 150001;
+    const std::vector<uchar> plain = Pattern(size, 23);
+    std::vector<uchar> ecb = plain, ctr = plain;
+    Encrypt(ecb.data(), ecb.data(), size, ctx);
+    EncryptCtr(ctr.data(), size - 3, ctx, 55, 7);
+
+    CHECK(WriteFile(path, plain));
+    CHECK(EncryptFile(path, ctx, 4u));
+    CHECK(ReadFile(path) == ecb);
+    CHECK(DecryptFile(path, ctx, ThreadExecutor(3)));
+    CHECK(ReadFile(path) == plain);
+    CHECK(EncryptFile(path, ctx, PoolExecutor(2)));
+    CHECK(ReadFile(path) == ecb);
+    CHECK(DecryptFile(path, ctx));
+    CHECK(ReadFile(path) == plain);
+
+    // CTR takes any size
+    std::vector<uchar> odd(plain.begin(), plain.end() - 3);
+    CHECK(WriteFile(path, odd));
+    CHECK(EncryptFileCtr(path, ctx, 55, 7, 4u));
+    CHECK(ReadFile(path) == std::vector<uchar>(ctr.begin(), ctr.end() - 3));
+    CHECK(DecryptFileCtr(path, ctx, 55, 7, ThreadExecutor(2)));
+    CHECK(ReadFile(path) == odd);
+
+    // ECB rejects a size which is not a multiple of the block and leaves the file alone
+    CHECK(!EncryptFile(path, ctx));
+    CHECK(!DecryptFile(path, ctx, ThreadExecutor(2)));
+    CHECK(ReadFile(path) == odd);
+
+    CHECK(WriteFile(path, std::vector<uchar>()));
+    CHECK(EncryptFile(path, ctx));
+    CHECK(ReadFile(path).empty());
+
+    unlink(path);
+    CHECK(!EncryptFile(path, ctx));
+    CHECK(!DecryptFile(path, ctx));
+    CHECK(!EncryptFileCtr(path, ctx, 55));
+    CHECK(!EncryptFile("/", ctx));
+}
+#endif
+
+#ifdef __cpp_lib_span
+static void TestSpan() {
+    std::array<std::byte, 16> key;
+    for (size_t i = 0; i < key.size(); i++) key[i] = (std::byte)(i * 13 + 2);
+    const std::array<std::byte, BLOCK_SIZE> iv = {};
+    const Context ctx((const uchar*)key.data());
+    const size_t size = 8 * 40001;
+    const std::vector<uchar> bytes = Pattern(size, 21);
+    std::vector<std::byte> plain(size);
+    memcpy(plain.data(), bytes.data(), size);
+    std::vector<std::byte> ref = plain;
+    Encrypt(ref.data(), ref.data(), size, ctx);
+
+    std::vector<std::byte> data = plain;
+    Encrypt(std::span<std::byte>(data), ctx);
+    CHECK(data == ref);
+    Decrypt(std::span<std::byte>(data), ctx, 0u);
+    CHECK(data == plain);
+    Encrypt(std::span<std::byte>(data), ctx, ThreadExecutor(3));
+    CHECK(data == ref);
+    Decrypt(std::span<std::byte>(data), ctx, ThreadExecutor(3));
+    CHECK(data == plain);
+    Encrypt(std::span<std::byte>(data), std::span<const std::byte, 16>(key));
+    CHECK(data == ref);
+    Decrypt(std::span<std::byte>(data), std::span<const std::byte, 16>(key));
+    CHECK(data == plain);
+
+    std::vector<std::byte> out(size);
+    Encrypt(std::span<const std::byte>(plain), std::span<std::byte>(out), ctx, 4u);
+    CHECK(out == ref);
+    Decrypt(std::span<const std::byte>(out), std::span<std::byte>(data), ctx);
+    CHECK(data == plain);
+
+    std::vector<std::byte> cbc = plain;
+    EncryptCbc((uchar*)cbc.data(), size, ctx, (const uchar*)iv.data());
+    EncryptCbc(std::span<std::byte>(data), ctx, iv);
+    CHECK(data == cbc);
+    DecryptCbc(std::span<std::byte>(data), ctx, iv, 0u);
+    CHECK(data == plain);
+
+    std::vector<std::byte> ctr = plain;
+    EncryptCtr((uchar*)ctr.data(), size - 3, ctx, 77, 5);
+    EncryptCtr(std::span<std::byte>(data.data(), size - 3), ctx, 77, 5);
+    CHECK(data == ctr);
+    DecryptCtr(std::span<std::byte>(data.data(), size - 3), ctx, 77, 5, ThreadExecutor(2));
+    CHECK(data == plain);
+
+    const XxteaContext xxtea((const uchar*)key.data());
+    std::vector<std::byte> word_block(plain.begin(), plain.begin() + 20);
+    CHECK(Encrypt(std::span<std::byte>(word_block), xxtea));
+    CHECK(!std::equal(word_block.begin(), word_block.end(), plain.begin()));
+    CHECK(Decrypt(std::span<std::byte>(word_block), xxtea));
+    CHECK(std::equal(word_block.begin(), word_block.end(), plain.begin()));
+    CHECK(!Encrypt(std::span<std::byte>(word_block.data(), 6), xxtea));
+}
+#endif
+
+
+/**
+ * Reference XXTEA (btea) from Wheeler and Needham's corrected block TEA
+ */
+static void ReferenceBtea(uint32_t* v, int n, const uint32_t key[4]) {
+    uint32_t y, z, sum;
+    unsigned p, rounds, e;
+#define MX (((z >> 5 ^ y << 2) + (y >> 3 ^ z << 4)) ^ ((sum ^ y) + (key[(p & 3) ^ e] ^ z)))
+    if (n > 1) {
+        rounds = 6 + 52 / n;
+        sum = 0;
+        z = v[n - 1];
+        do {
+            sum += DELTA;
+            e = (sum >> 2) & 3;
+            for (p = 0; p < (unsigned)n - 1; p++) {
+                y = v[p + 1];
+                z = v[p] += MX;
+            }
+            y = v[0];
+            z = v[n - 1] += MX;
+        } while (--rounds);
+    }
+#undef MX
+}
+
+/**
+ * XXTEA against the reference for every length from 2 words up, through the word
+ * and byte interfaces and the multi-message lanes, and rejection of short blocks
+ */
+static void TestBatch() {
+    const size_t n_messages = 53;
+    const Algorithm algorithms[] = { Algorithm::Xtea, Algorithm::Tea };
+    for (Algorithm algorithm : algorithms) {
+        std::vector<std::vector<uchar> > keys(n_messages), plain(n_messages), expected(n_messages);
+        for (size_t m = 0; m < n_messages; m++) {
+            keys[m] = Pattern(16, (uchar)(3 * m + 1));
+            plain[m] = Pattern((m * 37) % 211, (uchar)m);
+            expected[m] = plain[m];
+            const Context ctx(keys[m].data(), 32, ByteOrder::Little, algorithm);
+            Encrypt(expected[m].data(), expected[m].data(), expected[m].size(), ctx);
+        }
+        for (Kernel kernel : KERNELS) {
+            if (!SetKernel(kernel)) continue;
+            std::vector<std::vector<uchar> > data = plain;
+            std::vector<Message> messages(n_messages);
+            for (size_t m = 0; m < n_messages; m++) messages[m] = { data[m].data(), data[m].size(), keys[m].data() };
+            EncryptBatch(messages.data(), n_messages, 32, algorithm);
+            CHECK(data == expected);
+            DecryptBatch(messages.data(), n_messages, 32, algorithm);
+            CHECK(data == plain);
+        }
+    }
+    SetKernel(Kernel::Auto);
+}
+
+static void TestExecutors() {
+    uchar key[16];
+    for (int i = 0; i < 16; i++) key[i] = (uchar)(i * 9 + 6);
+    const Context ctx(key);
+    const uchar iv[BLOCK_SIZE] = { 3, 1, 4, 1, 5, 9, 2, 6 };
+    const size_t size = 8 * 300007;
+    const std::vector<uchar> plain = Pattern(size, 13);
+    std::vector<uchar> ecb = plain, ctr = plain, cbc = plain;
+    Encrypt(ecb.data(), ecb.data(), size, ctx);
+    EncryptCtr(ctr.data(), size - 5, ctx, 99, 11);
+    EncryptCbc(cbc.data(), size, ctx, iv);
+
+    // The thread count of the executor sizes the ranges even on a single CPU
+    size_t n_ranges = 0;
+    const Executor serial([&n_ranges](const Task& task) {
+        n_ranges = task.Size();
+        for (size_t i = 0; i < task.Size(); i++) task(i);
+    }, 4);
+    CHECK(serial.threads == 4);
+    CHECK(Executor(PoolExecutor(3)).threads == 3);
+    CHECK(Executor(ThreadExecutor(5)).threads == 5);
+    CHECK(!Executor());
+    std::vector<uchar> split(size);
+    Encrypt(plain.data(), split.data(), size, ctx, serial);
+    CHECK(split == ecb && n_ranges >= 4);
+
+    const Executor executors[] = { PoolExecutor(4), ThreadExecutor(4), serial, Executor() };
+    for (const Executor& executor : executors) {
+        std::vector<uchar> data(size);
+        Encrypt(plain.data(), data.data(), size, ctx, executor);
+        CHECK(data == ecb);
+        Decrypt(data.data(), data.data(), size, ctx, executor);
+        CHECK(data == plain);
+        EncryptCtr(data.data(), size - 5, ctx, 99, 11, executor);
+        CHECK(data == ctr);
+        DecryptCtr(data.data(), size - 5, ctx, 99, 11, executor);
+        CHECK(data == plain);
+        data = cbc;
+        DecryptCbc(data.data(), size, ctx, iv, executor);
+        CHECK(data == plain);
+    }
+
+    std::vector<uchar> data(size);
+    Encrypt(plain.data(), data.data(), size, ctx, 4u);
+    CHECK(data == ecb);
+    Decrypt(data.data(), data.data(), size, ctx, 4u);
+    CHECK(data == plain);
+}
+
+static void TestBatchParallel() {
+    // Runs of small messages, large ones split into several items, and odd sizes
+    std::vector<size_t> sizes;
+    for (size_t m = 0; m < 300; m++) sizes.push_back((m * 53) % 700);
+    sizes.push_back(8 * 20000 + 3);
+    for (size_t m = 0; m < 40; m++) sizes.push_back(8 * 600 + m);
+    sizes.push_back(8 * 8192);
+    sizes.push_back(0);
+    const size_t n_messages = sizes.size();
+    std::vector<std::vector<uchar> > keys(n_messages), plain(n_messages), expected(n_messages);
+    for (size_t m = 0; m < n_messages; m++) {
+        keys[m] = Pattern(16, (uchar)(7 * m + 2));
+        plain[m] = Pattern(sizes[m], (uchar)(m + 5));
+        expected[m] = plain[m];
+        Encrypt(expected[m].data(), expected[m].data(), sizes[m], Context(keys[m].data()));
+    }
+    const Executor executors[] = { ThreadExecutor(4), PoolExecutor(3) };
+    for (int run = 0; run < 4; run++) {
+        std::vector<std::vector<uchar> > data = plain;
+        std::vector<Message> messages(n_messages);
+        for (size_t m = 0; m < n_messages; m++) messages[m] = { data[m].data(), data[m].size(), keys[m].data() };
+        if (run < 2) EncryptBatch(messages.data(), n_messages, 32, Algorithm::Xtea, run == 0 ? 4u : 0u);
+        else EncryptBatch(messages.data(), n_messages, 32, Algorithm::Xtea, executors[run - 2]);
+        CHECK(data == expected);
+        if (run < 2) DecryptBatch(messages.data(), n_messages, 32, Algorithm::Xtea, run == 0 ? 4u : 0u);
+        else DecryptBatch(messages.data(), n_messages, 32, Algorithm::Xtea, executors[run - 2]);
+        CHECK(data == plain);
+    }
+}
+
+static void TestXxtea() {
+    const uint32_t key[4] = { 0x01234567, 0x89abcdef, 0xfedcba98, 0x76543210 };
+    const XxteaContext ctx(key);
+
+    uint32_t zero[2] = { 0, 0 };
+    const uint32_t zero_key[4] = { 0, 0, 0, 0 };
+    CHECK(EncipherBlock(zero, 2, XxteaContext(zero_key)));
+    CHECK(zero[0] == 0x053704ab && zero[1] == 0x575d8c80);
+
+    for (size_t n_words = 2; n_words <= 40; n_words++) {
+        std::vector<uint32_t> plain(n_words);
+        for (size_t i = 0; i < n_words; i++) plain[i] = (uint32_t)(i * 0x9e3779b1u + n_words);
+        std::vector<uint32_t> ref = plain, v = plain;
+        ReferenceBtea(ref.data(), (int)n_words, key);
+        CHECK(EncipherBlock(v.data(), n_words, ctx));
+        CHECK(v == ref);
+        std::vector<uchar> bytes(4 * n_words);
+        memcpy(bytes.data(), plain.data(), bytes.size());
+        CHECK(Encrypt(bytes.data(), bytes.size(), ctx));
+        CHECK(memcmp(bytes.data(), ref.data(), bytes.size()) == 0);
+        CHECK(DecipherBlock(v.data(), n_words, ctx));
+        CHECK(v == plain);
+    }
+
+    const size_t n_messages = 37, size = 4 * 13;
+    std::vector<uchar> batch = Pattern(n_messages * size, 17), ref = batch;
+    std::vector<uchar*> messages(n_messages);
+    for (size_t i = 0; i < n_messages; i++) {
+        messages[i] = batch.data() + size * i;
+        Encrypt(ref.data() + size * i, size, ctx);
+    }
+    for (Kernel kernel : KERNELS) {
+        if (!SetKernel(kernel)) continue;
+        std::vector<uchar> saved = batch;
+        CHECK(EncryptBatch(messages.data(), n_messages, size, ctx));
+        CHECK(batch == ref);
+        CHECK(DecryptBatch(messages.data(), n_messages, size, ctx));
+        CHECK(batch == saved);
+    }
+    SetKernel(Kernel::Auto);
+
+    uint32_t one[2] = { 1, 2 };
+    CHECK(!EncipherBlock(one, 1, ctx) && !DecipherBlock(one, 0, ctx));
+    CHECK(one[0] == 1 && one[1] == 2);
+    uchar short_message[4] = { 1, 2, 3, 4 };
+    CHECK(!Encrypt(short_message, 4, ctx));
+}
+
+int main() {
+    TestXteaKnownAnswer();
+    TestTeaKnownAnswer();
+    TestKernelEquivalence();
+    TestUnrolledRounds();
+    TestCbc();
+    TestCbcCs3();
+    TestCbcMultiBuffer();
+    TestExecutors();
+    TestBatch();
+    TestBatchParallel();
+    TestXxtea();
+    TestPartialBlocks();
+    TestTail();
+#ifdef XTEA_HAS_MMAP
+    TestFile();
+#endif
+#ifdef __cpp_lib_span
+    TestSpan();
+#endif
+    if (failures != 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All tests passed\n");
+    return 0;
+}
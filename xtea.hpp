@@ -2,15 +2,115 @@
 
 #ifdef QT_CORE_LIB
 #include <QByteArray>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
 #else
 #include <stdint.h>
 #endif /* ifdef(QT_CORE_LIB) */
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif /* ifdef(_OPENMP) */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+#ifdef __cpp_lib_span
+#include <cstddef>
+#include <span>
+#endif /* ifdef(__cpp_lib_span) */
+/**
+ * Overloads taking a standard execution policy are opt-in: with libstdc++, <execution>
+ * needs TBB at link time (-ltbb). Define XTEA_WITH_EXECUTION to enable them
+ */
+#if defined(XTEA_WITH_EXECUTION) && defined(__cpp_lib_execution)
+#define XTEA_HAS_EXECUTION
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <type_traits>
+#endif /* if(XTEA_WITH_EXECUTION && __cpp_lib_execution) */
+
+/**
+ * SIMD kernels are written with GCC/Clang vector extensions. On x86 each kernel
+ * is compiled for its own instruction set through a target attribute and the best
+ * one supported by the running CPU is picked once, see XTea::SetKernel.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XTEA_HAS_X86_SIMD
+#include <immintrin.h>
+#define XTEA_TARGET(isa) __attribute__((target(isa), flatten))
+#endif
+
+/**
+ * On Linux the thread pool groups its workers by NUMA node and runs each range of a
+ * buffer on the node holding its memory. The topology is read from sysfs and the page
+ * placement queried through the move_pages system call, so libnuma is not needed.
+ * Define XTEA_NO_NUMA to leave the workers unbound
+ */
+#if defined(__linux__) && !defined(XTEA_NO_NUMA)
+#define XTEA_HAS_NUMA
+#include <sched.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 /**
- * Uncomment the define to use TEA algorithm instead of XTEA.
- * TEA has less complex key-schedule and a rearrangement of the shifts, XORs, and additions.
+ * On POSIX systems files can be encrypted in place through a memory mapping,
+ * see XTea::EncryptFile
  */
- // #define USE_TEA_INSTEAD_OF_XTEA
+#if defined(__unix__) || defined(__APPLE__)
+#define XTEA_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define XTEA_BIG_ENDIAN_HOST
+#endif
+
+#if defined(__GNUC__)
+#define XTEA_FORCEINLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define XTEA_FORCEINLINE __forceinline
+#else
+#define XTEA_FORCEINLINE inline
+#endif
+
+/**
+ * TEA used to replace XTEA through a global define, which could not serve both in one
+ * program. Both are now available side by side, see XTea::Algorithm and XTea::Tea.
+ * The define is deprecated and will be removed in a later release; until then it makes
+ * TEA the default algorithm, see XTea::DEFAULT_ALGORITHM
+ */
+#ifdef USE_TEA_INSTEAD_OF_XTEA
+#if defined(_MSC_VER)
+#pragma message("USE_TEA_INSTEAD_OF_XTEA is deprecated: pass XTea::Algorithm::Tea to XTea::Context or use XTea::Tea")
+#else
+#warning "USE_TEA_INSTEAD_OF_XTEA is deprecated: pass XTea::Algorithm::Tea to XTea::Context or use XTea::Tea"
+#endif
+#endif
 
 namespace XTea {
 
@@ -25,7 +125,624 @@ typedef unsigned char uchar;
  */
 constexpr const uint32_t DELTA = 0x9E3779B9;
 
+/**
+ * @brief ByteOrder
+ * @details Order of the bytes of each 32-bit word of blocks and keys in memory.
+ * ByteOrder::Little is the default; ByteOrder::Big matches the usual XTEA test vectors
+ */
+enum class ByteOrder {
+    Little,
+    Big
+};
+
+/**
+ * @brief Algorithm
+ * @details Round function a Context is expanded for, see XTea::Xtea and XTea::Tea
+ */
+enum class Algorithm {
+    Xtea,
+    Tea
+};
+
+/**
+ * @brief DEFAULT_ALGORITHM
+ * @details Algorithm of the functions and contexts which are not given one:
+ * XTEA, or TEA under the deprecated USE_TEA_INSTEAD_OF_XTEA define
+ */
 #ifdef USE_TEA_INSTEAD_OF_XTEA
+constexpr const Algorithm DEFAULT_ALGORITHM = Algorithm::Tea;
+#else
+constexpr const Algorithm DEFAULT_ALGORITHM = Algorithm::Xtea;
+#endif
+
+namespace Detail {
+
+#ifdef XTEA_BIG_ENDIAN_HOST
+constexpr const ByteOrder HOST_ORDER = ByteOrder::Big;
+#else
+constexpr const ByteOrder HOST_ORDER = ByteOrder::Little;
+#endif
+
+/**
+ * @brief SwapBytes
+ * @details Reverses the bytes of each 32-bit word of a plain uint32_t or a vector of them
+ */
+template<class V>
+inline void SwapBytes(V& x) noexcept {
+    x = ((x >> 8 | x << 24) & 0xFF00FF00) | ((x << 8 | x >> 24) & 0x00FF00FF);
+}
+
+/**
+ * Blocks and keys are accessed in memory as 32-bit words of the given byte order,
+ * whatever the host, through memcpy: no alignment is required and no aliasing rule
+ * is broken. Compilers turn these into single (byte swapping) loads and stores.
+ */
+template<ByteOrder Order = ByteOrder::Little>
+inline uint32_t LoadWord(const uchar* p) noexcept {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    if (Order != HOST_ORDER) SwapBytes(w);
+    return w;
+}
+
+template<ByteOrder Order = ByteOrder::Little>
+inline void StoreWord(uchar* p, uint32_t w) noexcept {
+    if (Order != HOST_ORDER) SwapBytes(w);
+    memcpy(p, &w, sizeof(w));
+}
+
+inline void LoadBlock(uint32_t v[2], const uchar* p, ByteOrder order = ByteOrder::Little) noexcept {
+    v[0] = order == ByteOrder::Big ? LoadWord<ByteOrder::Big>(p) : LoadWord(p);
+    v[1] = order == ByteOrder::Big ? LoadWord<ByteOrder::Big>(p + 4) : LoadWord(p + 4);
+}
+
+inline void StoreBlock(uchar* p, const uint32_t v[2], ByteOrder order = ByteOrder::Little) noexcept {
+    if (order == ByteOrder::Big) {
+        StoreWord<ByteOrder::Big>(p, v[0]);
+        StoreWord<ByteOrder::Big>(p + 4, v[1]);
+    } else {
+        StoreWord(p, v[0]);
+        StoreWord(p + 4, v[1]);
+    }
+}
+
+/**
+ * @brief Key
+ * @details The four words of a 128-bit key given as bytes
+ */
+struct Key {
+    uint32_t w[4];
+
+    explicit Key(const uchar* p, ByteOrder order = ByteOrder::Little) noexcept {
+        for (uint i = 0; i < 4; i++) {
+            w[i] = order == ByteOrder::Big ? LoadWord<ByteOrder::Big>(p + 4 * i) : LoadWord(p + 4 * i);
+        }
+    }
+};
+
+/**
+ * @brief Schedule
+ * @details Round constants in the order they are consumed by one direction
+ */
+struct Schedule {
+    const uint32_t* key;        ///< The 128-bit key, which TEA rounds use directly
+    const uint32_t* round_keys; ///< 2 * n_rounds values, one per half-round
+    uint n_rounds;
+    ByteOrder order;            ///< Byte order of the words of the blocks
+    Algorithm algorithm;        ///< Round function the constants were expanded for
+};
+
+} // namespace Detail
+
+/**
+ * Round functions are written once for any lane type V: a plain uint32_t for the
+ * scalar path or a vector of uint32_t holding one block half per lane. G independent
+ * groups are processed together to hide the latency of the round dependency chain.
+ * Each algorithm is a policy type holding its rounds; the kernels, modes and threading
+ * take it as a template argument, so TEA and XTEA share everything else.
+ */
+
+/**
+ * @brief Xtea
+ * @details XTEA rounds, the default algorithm
+ */
+struct Xtea {
+    /**
+     * @brief EncipherBlock
+     * @param v 64 bit of block to encipher
+     * @param key Any 128-bit block
+     * @param n_rounds Number of rounds
+     */
+    static void EncipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds = 32) noexcept {
+        EncipherLanes<1>(&v[0], &v[1], key, n_rounds);
+    }
+
+    /**
+     * @brief DecipherBlock
+     * @param v 64 bit of block to decipher
+     * @param key Any 128-bit block which was used to encipher
+     * @param n_rounds Number of rounds which was used to encipher
+     */
+    static void DecipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds = 32) noexcept {
+        DecipherLanes<1>(&v[0], &v[1], key, n_rounds);
+    }
+
+    template<uint G, class V>
+    static void EncipherLanes(V v0[], V v1[], const uint32_t key[4], uint n_rounds) noexcept {
+        uint32_t sum = 0;
+        for (uint i = 0; i < n_rounds; i++) {
+            uint32_t k = sum + key[sum & 3];
+            for (uint g = 0; g < G; g++) v0[g] += (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ k;
+            sum  += DELTA;
+            k = sum + key[(sum >> 11) & 3];
+            for (uint g = 0; g < G; g++) v1[g] += (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ k;
+        }
+    }
+
+    template<uint G, class V>
+    static void DecipherLanes(V v0[], V v1[], const uint32_t key[4], uint n_rounds) noexcept {
+        uint32_t sum = DELTA * n_rounds;
+        for (uint i = 0; i < n_rounds; i++) {
+            uint32_t k = sum + key[(sum >> 11) & 3];
+            for (uint g = 0; g < G; g++) v1[g] -= (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ k;
+            sum  -= DELTA;
+            k = sum + key[sum & 3];
+            for (uint g = 0; g < G; g++) v0[g] -= (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ k;
+        }
+    }
+
+    /**
+     * @brief ExpandKey
+     * @details Writes sum + key[...] of each half-round to round_keys,
+     * in reverse order when expanding for decipher
+     */
+    static void ExpandKey(const uint32_t key[4], uint n_rounds, uint32_t* round_keys, bool decipher) noexcept {
+        const size_t last = 2 * (size_t)n_rounds - 1;
+        uint32_t sum = 0;
+        for (size_t i = 0; i < n_rounds; i++) {
+            round_keys[decipher ? last - 2 * i : 2 * i] = sum + key[sum & 3];
+            sum += DELTA;
+            round_keys[decipher ? last - 2 * i - 1 : 2 * i + 1] = sum + key[(sum >> 11) & 3];
+        }
+    }
+
+    template<uint G, class V>
+    static void EncipherLanes(V v0[], V v1[], const Detail::Schedule& s) noexcept {
+        const uint32_t* rk = s.round_keys;
+        for (uint i = 0; i < s.n_rounds; i++, rk += 2) {
+            for (uint g = 0; g < G; g++) v0[g] += (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ rk[0];
+            for (uint g = 0; g < G; g++) v1[g] += (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ rk[1];
+        }
+    }
+
+    template<uint G, class V>
+    static void DecipherLanes(V v0[], V v1[], const Detail::Schedule& s) noexcept {
+        const uint32_t* rk = s.round_keys;
+        for (uint i = 0; i < s.n_rounds; i++, rk += 2) {
+            for (uint g = 0; g < G; g++) v1[g] -= (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ rk[0];
+            for (uint g = 0; g < G; g++) v0[g] -= (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ rk[1];
+        }
+    }
+
+    /**
+     * @brief EncipherRound, DecipherRound
+     * @details Round I of Rounds for Detail::UnrolledRounds. Given the raw key the sum
+     * and the key index are immediates; given a Schedule the round constants are
+     * read at a fixed offset
+     */
+    template<uint I, uint Rounds, uint G, class V>
+    static XTEA_FORCEINLINE void EncipherRound(V v0[], V v1[], const uint32_t key[4]) noexcept {
+        constexpr uint32_t sum = I * DELTA;
+        constexpr uint32_t next = sum + DELTA;
+        for (uint g = 0; g < G; g++) v0[g] += (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ (sum + key[sum & 3]);
+        for (uint g = 0; g < G; g++) v1[g] += (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ (next + key[(next >> 11) & 3]);
+    }
+
+    template<uint I, uint Rounds, uint G, class V>
+    static XTEA_FORCEINLINE void DecipherRound(V v0[], V v1[], const uint32_t key[4]) noexcept {
+        constexpr uint32_t sum = (Rounds - I) * DELTA;
+        constexpr uint32_t prev = sum - DELTA;
+        for (uint g = 0; g < G; g++) v1[g] -= (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ (sum + key[(sum >> 11) & 3]);
+        for (uint g = 0; g < G; g++) v0[g] -= (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ (prev + key[prev & 3]);
+    }
+
+    template<uint I, uint Rounds, uint G, class V>
+    static XTEA_FORCEINLINE void EncipherRound(V v0[], V v1[], const Detail::Schedule& s) noexcept {
+        const uint32_t* rk = s.round_keys + 2 * I;
+        for (uint g = 0; g < G; g++) v0[g] += (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ rk[0];
+        for (uint g = 0; g < G; g++) v1[g] += (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ rk[1];
+    }
+
+    template<uint I, uint Rounds, uint G, class V>
+    static XTEA_FORCEINLINE void DecipherRound(V v0[], V v1[], const Detail::Schedule& s) noexcept {
+        const uint32_t* rk = s.round_keys + 2 * I;
+        for (uint g = 0; g < G; g++) v1[g] -= (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ rk[0];
+        for (uint g = 0; g < G; g++) v0[g] -= (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ rk[1];
+    }
+
+    /**
+     * @brief EncipherKeyedLanes, DecipherKeyedLanes
+     * @details Rounds with a key per lane: group g uses the key words key[4 * g .. 4 * g + 3].
+     * The sum, and so the key word each half-round picks, is the same in every lane
+     */
+    template<uint G, class V>
+    static void EncipherKeyedLanes(V v0[], V v1[], const V key[], uint n_rounds) noexcept {
+        uint32_t sum = 0;
+        for (uint i = 0; i < n_rounds; i++) {
+            for (uint g = 0; g < G; g++) v0[g] += (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ (sum + key[4 * g + (sum & 3)]);
+            sum += DELTA;
+            for (uint g = 0; g < G; g++) v1[g] += (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ (sum + key[4 * g + ((sum >> 11) & 3)]);
+        }
+    }
+
+    template<uint G, class V>
+    static void DecipherKeyedLanes(V v0[], V v1[], const V key[], uint n_rounds) noexcept {
+        uint32_t sum = DELTA * n_rounds;
+        for (uint i = 0; i < n_rounds; i++) {
+            for (uint g = 0; g < G; g++) v1[g] -= (((v0[g] << 4) ^ (v0[g] >> 5)) + v0[g]) ^ (sum + key[4 * g + ((sum >> 11) & 3)]);
+            sum -= DELTA;
+            for (uint g = 0; g < G; g++) v0[g] -= (((v1[g] << 4) ^ (v1[g] >> 5)) + v1[g]) ^ (sum + key[4 * g + (sum & 3)]);
+        }
+    }
+
+    /**
+     * @brief EncipherPlanes, DecipherPlanes
+     * @details Rounds of the bitsliced engine, defined along with it
+     */
+    template<class P>
+    static void EncipherPlanes(P v0[32], P v1[32], const Detail::Schedule& s) noexcept;
+
+    template<class P>
+    static void DecipherPlanes(P v0[32], P v1[32], const Detail::Schedule& s) noexcept;
+};
+
+/**
+ * @brief Tea
+ * @details TEA rounds. TEA has less complex key-schedule and
+ * a rearrangement of the shifts, XORs, and additions
+ */
+struct Tea {
+    /**
+     * @brief EncipherBlock
+     * @param v 64 bit of block to encipher
+     * @param key Any 128-bit block
+     * @param n_rounds Number of rounds
+     */
+    static void EncipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds = 32) noexcept {
+        EncipherLanes<1>(&v[0], &v[1], key, n_rounds);
+    }
+
+    /**
+     * @brief DecipherBlock
+     * @param v 64 bit of block to decipher
+     * @param key Any 128-bit block which was used to encipher
+     * @param n_rounds Number of rounds which was used to encipher
+     */
+    static void DecipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds = 32) noexcept {
+        DecipherLanes<1>(&v[0], &v[1], key, n_rounds);
+    }
+
+    template<uint G, class V>
+    static void EncipherLanes(V v0[], V v1[], const uint32_t key[4], uint n_rounds) noexcept {
+        uint32_t sum = 0;
+        for (uint i = 0; i < n_rounds; i++) {
+            sum  += DELTA;
+            for (uint g = 0; g < G; g++) v0[g] += ((v1[g] << 4) + key[0]) ^ (v1[g] + sum) ^ ((v1[g] >> 5) + key[1]);
+            for (uint g = 0; g < G; g++) v1[g] += ((v0[g] << 4) + key[2]) ^ (v0[g] + sum) ^ ((v0[g] >> 5) + key[3]);
+        }
+    }
+
+    template<uint G, class V>
+    static void DecipherLanes(V v0[], V v1[], const uint32_t key[4], uint n_rounds) noexcept {
+        uint32_t sum = n_rounds * DELTA;
+        for (uint i = 0; i < n_rounds; i++) {
+            for (uint g = 0; g < G; g++) v1[g] -= ((v0[g] << 4) + key[2]) ^ (v0[g] + sum) ^ ((v0[g] >> 5) + key[3]);
+            for (uint g = 0; g < G; g++) v0[g] -= ((v1[g] << 4) + key[0]) ^ (v1[g] + sum) ^ ((v1[g] >> 5) + key[1]);
+            sum  -= DELTA;
+        }
+    }
+
+    /**
+     * @brief ExpandKey
+     * @details Writes the running sum of each half-round to round_keys,
+     * in reverse order when expanding for decipher
+     */
+    static void ExpandKey(const uint32_t key[4], uint n_rounds, uint32_t* round_keys, bool decipher) noexcept {
+        (void)key;
+        const size_t last = 2 * (size_t)n_rounds - 1;
+        uint32_t sum = 0;
+        for (size_t i = 0; i < n_rounds; i++) {
+            sum += DELTA;
+            round_keys[decipher ? last - 2 * i : 2 * i] = sum;
+            round_keys[decipher ? last - 2 * i - 1 : 2 * i + 1] = sum;
+        }
+    }
+
+    template<uint G, class V>
+    static void EncipherLanes(V v0[], V v1[], const Detail::Schedule& s) noexcept {
+        const uint32_t* key = s.key;
+        const uint32_t* rk = s.round_keys;
+        for (uint i = 0; i < s.n_rounds; i++, rk += 2) {
+            for (uint g = 0; g < G; g++) v0[g] += ((v1[g] << 4) + key[0]) ^ (v1[g] + rk[0]) ^ ((v1[g] >> 5) + key[1]);
+            for (uint g = 0; g < G; g++) v1[g] += ((v0[g] << 4) + key[2]) ^ (v0[g] + rk[1]) ^ ((v0[g] >> 5) + key[3]);
+        }
+    }
+
+    template<uint G, class V>
+    static void DecipherLanes(V v0[], V v1[], const Detail::Schedule& s) noexcept {
+        const uint32_t* key = s.key;
+        const uint32_t* rk = s.round_keys;
+        for (uint i = 0; i < s.n_rounds; i++, rk += 2) {
+            for (uint g = 0; g < G; g++) v1[g] -= ((v0[g] << 4) + key[2]) ^ (v0[g] + rk[0]) ^ ((v0[g] >> 5) + key[3]);
+            for (uint g = 0; g < G; g++) v0[g] -= ((v1[g] << 4) + key[0]) ^ (v1[g] + rk[1]) ^ ((v1[g] >> 5) + key[1]);
+        }
+    }
+
+    /**
+     * @brief EncipherRound, DecipherRound
+     * @details Round I of Rounds for Detail::UnrolledRounds. The sums are immediates
+     * and TEA rounds use the raw key, so a Schedule contributes only its key
+     */
+    template<uint I, uint Rounds, uint G, class V>
+    static XTEA_FORCEINLINE void EncipherRound(V v0[], V v1[], const uint32_t key[4]) noexcept {
+        constexpr uint32_t sum = (I + 1) * DELTA;
+        for (uint g = 0; g < G; g++) v0[g] += ((v1[g] << 4) + key[0]) ^ (v1[g] + sum) ^ ((v1[g] >> 5) + key[1]);
+        for (uint g = 0; g < G; g++) v1[g] += ((v0[g] << 4) + key[2]) ^ (v0[g] + sum) ^ ((v0[g] >> 5) + key[3]);
+    }
+
+    template<uint I, uint Rounds, uint G, class V>
+    static XTEA_FORCEINLINE void DecipherRound(V v0[], V v1[], const uint32_t key[4]) noexcept {
+        constexpr uint32_t sum = (Rounds - I) * DELTA;
+        for (uint g = 0; g < G; g++) v1[g] -= ((v0[g] << 4) + key[2]) ^ (v0[g] + sum) ^ ((v0[g] >> 5) + key[3]);
+        for (uint g = 0; g < G; g++) v0[g] -= ((v1[g] << 4) + key[0]) ^ (v1[g] + sum) ^ ((v1[g] >> 5) + key[1]);
+    }
+
+    template<uint I, uint Rounds, uint G, class V>
+    static XTEA_FORCEINLINE void EncipherRound(V v0[], V v1[], const Detail::Schedule& s) noexcept {
+        EncipherRound<I, Rounds, G>(v0, v1, s.key);
+    }
+
+    template<uint I, uint Rounds, uint G, class V>
+    static XTEA_FORCEINLINE void DecipherRound(V v0[], V v1[], const Detail::Schedule& s) noexcept {
+        DecipherRound<I, Rounds, G>(v0, v1, s.key);
+    }
+
+    /**
+     * @brief EncipherKeyedLanes, DecipherKeyedLanes
+     * @details Rounds with a key per lane, see Xtea::EncipherKeyedLanes
+     */
+    template<uint G, class V>
+    static void EncipherKeyedLanes(V v0[], V v1[], const V key[], uint n_rounds) noexcept {
+        uint32_t sum = 0;
+        for (uint i = 0; i < n_rounds; i++) {
+            sum += DELTA;
+            for (uint g = 0; g < G; g++) {
+                const V* k = key + 4 * g;
+                v0[g] += ((v1[g] << 4) + k[0]) ^ (v1[g] + sum) ^ ((v1[g] >> 5) + k[1]);
+            }
+            for (uint g = 0; g < G; g++) {
+                const V* k = key + 4 * g;
+                v1[g] += ((v0[g] << 4) + k[2]) ^ (v0[g] + sum) ^ ((v0[g] >> 5) + k[3]);
+            }
+        }
+    }
+
+    template<uint G, class V>
+    static void DecipherKeyedLanes(V v0[], V v1[], const V key[], uint n_rounds) noexcept {
+        uint32_t sum = n_rounds * DELTA;
+        for (uint i = 0; i < n_rounds; i++) {
+            for (uint g = 0; g < G; g++) {
+                const V* k = key + 4 * g;
+                v1[g] -= ((v0[g] << 4) + k[2]) ^ (v0[g] + sum) ^ ((v0[g] >> 5) + k[3]);
+            }
+            for (uint g = 0; g < G; g++) {
+                const V* k = key + 4 * g;
+                v0[g] -= ((v1[g] << 4) + k[0]) ^ (v1[g] + sum) ^ ((v1[g] >> 5) + k[1]);
+            }
+            sum -= DELTA;
+        }
+    }
+
+    template<class P>
+    static void EncipherPlanes(P v0[32], P v1[32], const Detail::Schedule& s) noexcept;
+
+    template<class P>
+    static void DecipherPlanes(P v0[32], P v1[32], const Detail::Schedule& s) noexcept;
+};
+
+namespace Detail {
+
+/**
+ * @brief ExpandKey
+ * @details Key expansion of the given algorithm
+ */
+inline void ExpandKey(const uint32_t key[4], uint n_rounds, uint32_t* round_keys, bool decipher, Algorithm algorithm) noexcept {
+    if (algorithm == Algorithm::Tea) Tea::ExpandKey(key, n_rounds, round_keys, decipher);
+    else Xtea::ExpandKey(key, n_rounds, round_keys, decipher);
+}
+
+/**
+ * @brief EncipherLanes, DecipherLanes
+ * @details Rounds of the algorithm of the schedule, for paths that handle a few
+ * blocks per call; the kernels take the algorithm as a template argument instead
+ */
+template<uint G, class V>
+inline void EncipherLanes(V v0[], V v1[], const Schedule& s) noexcept {
+    if (s.algorithm == Algorithm::Tea) Tea::EncipherLanes<G>(v0, v1, s);
+    else Xtea::EncipherLanes<G>(v0, v1, s);
+}
+
+template<uint G, class V>
+inline void DecipherLanes(V v0[], V v1[], const Schedule& s) noexcept {
+    if (s.algorithm == Algorithm::Tea) Tea::DecipherLanes<G>(v0, v1, s);
+    else Xtea::DecipherLanes<G>(v0, v1, s);
+}
+
+/**
+ * @brief UnrolledRounds
+ * @details Rounds I..Rounds-1 of Cipher unrolled at compile time. The SIMD kernels
+ * prefer round constants at fixed offsets, since a broadcast from memory is cheaper
+ * than one from a general register
+ */
+template<class Cipher, uint I, uint Rounds>
+struct UnrolledRounds {
+    template<uint G, class V, class K>
+    static XTEA_FORCEINLINE void Encipher(V v0[], V v1[], const K& key) noexcept {
+        Cipher::template EncipherRound<I, Rounds, G>(v0, v1, key);
+        UnrolledRounds<Cipher, I + 1, Rounds>::template Encipher<G>(v0, v1, key);
+    }
+
+    template<uint G, class V, class K>
+    static XTEA_FORCEINLINE void Decipher(V v0[], V v1[], const K& key) noexcept {
+        Cipher::template DecipherRound<I, Rounds, G>(v0, v1, key);
+        UnrolledRounds<Cipher, I + 1, Rounds>::template Decipher<G>(v0, v1, key);
+    }
+};
+
+template<class Cipher, uint Rounds>
+struct UnrolledRounds<Cipher, Rounds, Rounds> {
+    template<uint G, class V, class K>
+    static XTEA_FORCEINLINE void Encipher(V[], V[], const K&) noexcept {}
+
+    template<uint G, class V, class K>
+    static XTEA_FORCEINLINE void Decipher(V[], V[], const K&) noexcept {}
+};
+
+/**
+ * @brief LaneRounds
+ * @details Round loop used by the kernels: unrolled when the number of rounds
+ * is a compile-time constant, driven by the schedule when Rounds is 0
+ */
+template<class Cipher, uint Rounds>
+struct LaneRounds {
+    template<uint G, class V>
+    static XTEA_FORCEINLINE void Encipher(V v0[], V v1[], const Schedule& s) noexcept {
+        UnrolledRounds<Cipher, 0, Rounds>::template Encipher<G>(v0, v1, s);
+    }
+
+    template<uint G, class V>
+    static XTEA_FORCEINLINE void Decipher(V v0[], V v1[], const Schedule& s) noexcept {
+        UnrolledRounds<Cipher, 0, Rounds>::template Decipher<G>(v0, v1, s);
+    }
+};
+
+template<class Cipher>
+struct LaneRounds<Cipher, 0> {
+    template<uint G, class V>
+    static XTEA_FORCEINLINE void Encipher(V v0[], V v1[], const Schedule& s) noexcept {
+        Cipher::template EncipherLanes<G>(v0, v1, s);
+    }
+
+    template<uint G, class V>
+    static XTEA_FORCEINLINE void Decipher(V v0[], V v1[], const Schedule& s) noexcept {
+        Cipher::template DecipherLanes<G>(v0, v1, s);
+    }
+};
+
+/**
+ * @brief EncipherBytes
+ * @details Enciphers the block at src into dst, which may be src
+ */
+inline void EncipherBytes(uchar* dst, const uchar* src, const Schedule& s) noexcept {
+    uint32_t v[2];
+    LoadBlock(v, src, s.order);
+    EncipherLanes<1>(&v[0], &v[1], s);
+    StoreBlock(dst, v, s.order);
+}
+
+/**
+ * @brief DecipherBytes
+ * @details Counterpart of EncipherBytes
+ */
+inline void DecipherBytes(uchar* dst, const uchar* src, const Schedule& s) noexcept {
+    uint32_t v[2];
+    LoadBlock(v, src, s.order);
+    DecipherLanes<1>(&v[0], &v[1], s);
+    StoreBlock(dst, v, s.order);
+}
+
+} // namespace Detail
+
+/**
+ * @brief Context
+ * @details Key schedule expanded once from a 128-bit key and a number of rounds,
+ * to be reused across calls. Holds the 2 * n_rounds round constants in encipher
+ * order followed by the same constants reversed for decipher, the algorithm
+ * and the byte order of the data it is used on
+ */
+class Context {
+public:
+    /**
+     * @param key Any 128-bit block
+     * @param n_rounds Number of rounds. More rounds means
+     * better cryptographic strength and is therefore slower execution time
+     * @param order Byte order of the words of the data blocks
+     * @param algorithm XTEA or TEA rounds
+     */
+    explicit Context(const uint32_t key[4], uint n_rounds = 32, ByteOrder order = ByteOrder::Little,
+                     Algorithm algorithm = DEFAULT_ALGORITHM)
+        : n_rounds_(n_rounds), order_(order), algorithm_(algorithm), round_keys_(4 * (size_t)n_rounds) {
+        memcpy(key_, key, sizeof(key_));
+        Detail::ExpandKey(key_, n_rounds, round_keys_.data(), false, algorithm);
+        Detail::ExpandKey(key_, n_rounds, round_keys_.data() + 2 * (size_t)n_rounds, true, algorithm);
+    }
+
+    /**
+     * @param key Pointer to any 128-bit block
+     * @param n_rounds Number of rounds
+     * @param order Byte order of the words of the key and of the data blocks
+     * @param algorithm XTEA or TEA rounds
+     */
+    explicit Context(const uchar* key, uint n_rounds = 32, ByteOrder order = ByteOrder::Little,
+                     Algorithm algorithm = DEFAULT_ALGORITHM)
+        : Context(Detail::Key(key, order).w, n_rounds, order, algorithm) {}
+
+#ifdef QT_CORE_LIB
+    /**
+     * @param key Any bytearray of 128 bit long
+     * @param n_rounds Number of rounds
+     * @param order Byte order of the words of the key and of the data blocks
+     * @param algorithm XTEA or TEA rounds
+     */
+    explicit Context(const QByteArray& key, uint n_rounds = 32, ByteOrder order = ByteOrder::Little,
+                     Algorithm algorithm = DEFAULT_ALGORITHM)
+        : Context((const uchar*)key.constData(), n_rounds, order, algorithm) {}
+#endif /* ifdef(QT_CORE_LIB) */
+
+    /**
+     * @brief Rounds
+     * @return Number of rounds the key was expanded for
+     */
+    uint Rounds() const noexcept { return n_rounds_; }
+
+    /**
+     * @brief Order
+     * @return Byte order of the data blocks
+     */
+    ByteOrder Order() const noexcept { return order_; }
+
+    /**
+     * @brief Cipher
+     * @return Algorithm the key was expanded for
+     */
+    Algorithm Cipher() const noexcept { return algorithm_; }
+
+    Detail::Schedule EncipherSchedule() const noexcept {
+        return { key_, round_keys_.data(), n_rounds_, order_, algorithm_ };
+    }
+
+    Detail::Schedule DecipherSchedule() const noexcept {
+        return { key_, round_keys_.data() + 2 * (size_t)n_rounds_, n_rounds_, order_, algorithm_ };
+    }
+
+private:
+    uint32_t key_[4];
+    uint n_rounds_;
+    ByteOrder order_;
+    Algorithm algorithm_;
+    std::vector<uint32_t> round_keys_;
+};
+
 /**
  * @brief EncipherBlock
  * @param v 64 bit of block to encipher
@@ -34,12 +751,8 @@ constexpr const uint32_t DELTA = 0x9E3779B9;
  * better cryptographic strength and is therefore slower execution time
  */
 inline void EncipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds) noexcept {
-    uint32_t sum = 0;
-    for (uint i = 0; i < n_rounds; i++) {
-        sum  += DELTA;
-        v[0] += ((v[1] << 4) + key[0]) ^ (v[1] + sum) ^ ((v[1] >> 5) + key[1]);
-        v[1] += ((v[0] << 4) + key[2]) ^ (v[0] + sum) ^ ((v[0] >> 5) + key[3]);
-    }
+    if (DEFAULT_ALGORITHM == Algorithm::Tea) Tea::EncipherBlock(v, key, n_rounds);
+    else Xtea::EncipherBlock(v, key, n_rounds);
 }
 
 /**
@@ -49,97 +762,3999 @@ inline void EncipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds) n
  * @param n_rounds Number of rounds which was used to encipher
  */
 inline void DecipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds) noexcept {
-    uint32_t sum = n_rounds * DELTA;
-    for (uint i = 0; i < n_rounds; i++) {
-        v[1] -= ((v[0] << 4) + key[2]) ^ (v[0] + sum) ^ ((v[0] >> 5) + key[3]);
-        v[0] -= ((v[1] << 4) + key[0]) ^ (v[1] + sum) ^ ((v[1] >> 5) + key[1]);
-        sum  -= DELTA;
-    }
+    if (DEFAULT_ALGORITHM == Algorithm::Tea) Tea::DecipherBlock(v, key, n_rounds);
+    else Xtea::DecipherBlock(v, key, n_rounds);
 }
-#else
+
 /**
  * @brief EncipherBlock
  * @param v 64 bit of block to encipher
- * @param key Any 128-bit block
- * @param n_rounds 4
+ * @param ctx Expanded key
  */
-inline void EncipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds) noexcept {
-    uint32_t sum = 0;
-    for (uint i = 0; i < n_rounds; i++) {
-        v[0] += ((v[1] << 4) ^ (v[1] >> 5) + v[1]) ^ (sum + key[sum & 3]);
-        sum  += DELTA;
-        v[0] += ((v[0] << 4) ^ (v[0] >> 5) + v[0]) ^ (sum + key[(sum >> 11) & 3]);
-    }
+inline void EncipherBlock(uint32_t v[2], const Context& ctx) noexcept {
+    Detail::EncipherLanes<1>(&v[0], &v[1], ctx.EncipherSchedule());
 }
 
 /**
  * @brief DecipherBlock
  * @param v 64 bit of block to decipher
- * @param key Any 128-bit block which was used to encipher
- * @param n_rounds Number of rounds which was used to encipher
+ * @param ctx Expanded key which was used to encipher
  */
-inline void DecipherBlock(uint32_t v[2], const uint32_t key[4], uint n_rounds) noexcept {
-    uint32_t sum = DELTA * n_rounds;
-    for (uint i = 0; i < n_rounds; i++) {
-        v[1] -= ((v[0] << 4) ^ (v[0] >> 5) + v[0]) ^ (sum + key[(sum >> 11) & 3]);
-        sum  -= DELTA;
-        v[0] -= ((v[1] << 4) ^ (v[1] >> 5) + v[1]) ^ (sum + key[sum & 3]);
-    }
+inline void DecipherBlock(uint32_t v[2], const Context& ctx) noexcept {
+    Detail::DecipherLanes<1>(&v[0], &v[1], ctx.DecipherSchedule());
 }
-#endif
 
 /**
- * @brief Encrypt
- * @param data Pointer to the data that will be encrypted. No additional data will be created
- * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @brief EncipherBlock
+ * @details Fully unrolled variant for a number of rounds known at compile time
+ * @tparam Rounds Number of rounds
+ * @tparam Cipher Xtea or Tea
+ * @param v 64 bit of block to encipher
  * @param key Any 128-bit block
- * @param n_rounds Number of rounds. More rounds means
- * better cryptographic strength and is therefore slower execution time
  */
-inline void Encrypt(uchar* data, uint size, uchar* key, uint n_rounds = 32) noexcept {
-    int n_blocks = size / BLOCK_SIZE;
-    if(size % BLOCK_SIZE != 0) n_blocks++;
-    for(int i = 0; i < n_blocks; i++) {
-        EncipherBlock((uint32_t*)(data + (BLOCK_SIZE * i)), (uint32_t*)key, n_rounds);
-    }
+template<uint Rounds, class Cipher = Xtea>
+inline void EncipherBlock(uint32_t v[2], const uint32_t key[4]) noexcept {
+    Detail::UnrolledRounds<Cipher, 0, Rounds>::template Encipher<1>(&v[0], &v[1], key);
 }
 
 /**
- * @brief Decrypt
- * @param data Pointer to the data that will be encrypted.
- * @param size Size of data provided in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @brief DecipherBlock
+ * @details Fully unrolled variant for a number of rounds known at compile time
+ * @tparam Rounds Number of rounds which was used to encipher
+ * @tparam Cipher Algorithm which was used to encipher
+ * @param v 64 bit of block to decipher
  * @param key Any 128-bit block which was used to encipher
- * @param n_rounds Number of rounds which was used to encrypt
  */
-inline void Decrypt(uchar* data, uint size, uchar* key, uint n_rounds = 32) noexcept {
-    int n_blocks = size / BLOCK_SIZE;
-    if(size % BLOCK_SIZE != 0) n_blocks++;
-    for(int i = 0; i < n_blocks; i++) {
-        DecipherBlock((uint32_t*)(data + (BLOCK_SIZE * i)), (uint32_t*)key, n_rounds);
-    }
+template<uint Rounds, class Cipher = Xtea>
+inline void DecipherBlock(uint32_t v[2], const uint32_t key[4]) noexcept {
+    Detail::UnrolledRounds<Cipher, 0, Rounds>::template Decipher<1>(&v[0], &v[1], key);
 }
 
-#ifdef QT_CORE_LIB
+namespace Detail {
 
 /**
- * @brief Encrypt
- * @param data Reference to data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
- * @param key Any bytearray of 128 bit long
- * @param n_rounds Number of rounds. More rounds means
- * better cryptographic strength and is therefore slower execution time
+ * @brief XXTEA_MAX_CYCLES
+ * @details Number of cycles of XXTEA over the shortest block of two words
  */
-inline void Encrypt(QByteArray& data, const QByteArray& key, uint n_rounds = 32) noexcept {
-    Encrypt((uchar*)data.data(), data.size(), (uchar*)key.constData(), n_rounds);
-}
+constexpr const uint XXTEA_MAX_CYCLES = 6 + 52 / 2;
 
 /**
- * @brief Decrypt
- * @param data Reference to data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
- * @param key Any bytearray of 128 bit long which was used to encrypt
- * @param n_rounds Number of rounds which was used to encrypt
+ * @brief XxteaSchedule
+ * @details Per cycle of XXTEA, the running sum and the key words already
+ * permuted by the (sum >> 2) & 3 of the cycle, so word p takes key[p & 3]
  */
-inline void Decrypt(QByteArray& data, const QByteArray& key, uint n_rounds = 32) noexcept {
-    Decrypt((uchar*)data.data(), data.size(), (uchar*)key.constData(), n_rounds);
+struct XxteaSchedule {
+    uint32_t sum[XXTEA_MAX_CYCLES];
+    uint32_t key[XXTEA_MAX_CYCLES][4];
+};
+
+/**
+ * @brief ByteWords
+ * @details Words of an XXTEA block read and written in place in memory
+ */
+template<ByteOrder Order>
+struct ByteWords {
+    typedef uint32_t Lane;
+    uchar* p;
+
+    void Load(size_t i, uint32_t& w) const noexcept { w = LoadWord<Order>(p + 4 * i); }
+    void Store(size_t i, const uint32_t& w) const noexcept { StoreWord<Order>(p + 4 * i, w); }
+};
+
+/**
+ * @brief LaneWords
+ * @details Words of as many XXTEA blocks as V has lanes, interleaved so that
+ * word i of every block is one V. A plain uint32_t is a single block in host order
+ */
+template<class V>
+struct LaneWords {
+    typedef V Lane;
+    uint32_t* p;
+
+    void Load(size_t i, V& w) const noexcept { memcpy(&w, p + i * (sizeof(V) / sizeof(uint32_t)), sizeof(V)); }
+    void Store(size_t i, const V& w) const noexcept { memcpy(p + i * (sizeof(V) / sizeof(uint32_t)), &w, sizeof(V)); }
+};
+
+} // namespace Detail
+
+/**
+ * @brief Xxtea
+ * @details XXTEA (Corrected Block TEA) rounds, which encipher a whole message of
+ * n >= 2 words as one block in 6 + 52 / n cycles. Long messages take fewer operations
+ * per byte than XTEA and need no padding, but the ciphertext is not compatible with
+ * XTEA or TEA, and changing any word changes the whole block
+ */
+struct Xxtea {
+    /**
+     * @brief Cycles
+     * @param n_words Number of 32-bit words of the block, at least 2
+     * @return Number of passes over the block
+     */
+    static uint Cycles(size_t n_words) noexcept {
+        return 6 + (uint)(52 / n_words);
+    }
+
+    static void ExpandKey(const uint32_t key[4], Detail::XxteaSchedule& s) noexcept {
+        uint32_t sum = 0;
+        for (uint c = 0; c < Detail::XXTEA_MAX_CYCLES; c++) {
+            sum += DELTA;
+            const uint e = (sum >> 2) & 3;
+            s.sum[c] = sum;
+            for (uint i = 0; i < 4; i++) s.key[c][i] = key[i ^ e];
+        }
+    }
+
+    /**
+     * @brief Mix
+     * @details The MX function of XXTEA; key is the schedule word already xor-ed in by index
+     */
+    template<class V>
+    static XTEA_FORCEINLINE void Mix(V& t, const V& y, const V& z, uint32_t sum, uint32_t key) noexcept {
+        t = (((z >> 5) ^ (y << 2)) + ((y >> 3) ^ (z << 4))) ^ ((sum ^ y) + (key ^ z));
+    }
+
+    /**
+     * @brief Encipher
+     * @details Runs the cycles over n_words words accessed through Words::Load and Words::Store,
+     * one block for ByteWords and a block per lane for LaneWords. Does nothing for
+     * fewer than 2 words
+     */
+    template<class Words>
+    static void Encipher(const Words& v, size_t n_words, const Detail::XxteaSchedule& s) noexcept {
+        typedef typename Words::Lane V;
+        if (n_words < 2) return;
+        const uint n_cycles = Cycles(n_words);
+        V x, y, z, t;
+        v.Load(n_words - 1, z);
+        for (uint c = 0; c < n_cycles; c++) {
+            const uint32_t sum = s.sum[c];
+            const uint32_t* k = s.key[c];
+            // x is word p before this cycle updates it, y the word after it
+            v.Load(0, x);
+            for (size_t p = 0; p + 1 < n_words; p++) {
+                v.Load(p + 1, y);
+                Mix(t, y, z, sum, k[p & 3]);
+                z = x + t;
+                v.Store(p, z);
+                x = y;
+            }
+            v.Load(0, y);
+            Mix(t, y, z, sum, k[(n_words - 1) & 3]);
+            z = x + t;
+            v.Store(n_words - 1, z);
+        }
+    }
+
+    template<class Words>
+    static void Decipher(const Words& v, size_t n_words, const Detail::XxteaSchedule& s) noexcept {
+        typedef typename Words::Lane V;
+        if (n_words < 2) return;
+        const uint n_cycles = Cycles(n_words);
+        V x, y, z, t;
+        v.Load(0, y);
+        for (uint c = n_cycles; c-- > 0;) {
+            const uint32_t sum = s.sum[c];
+            const uint32_t* k = s.key[c];
+            // x is word p before this cycle restores it, z the word before it
+            v.Load(n_words - 1, x);
+            for (size_t p = n_words - 1; p > 0; p--) {
+                v.Load(p - 1, z);
+                Mix(t, y, z, sum, k[p & 3]);
+                y = x - t;
+                v.Store(p, y);
+                x = z;
+            }
+            v.Load(n_words - 1, z);
+            Mix(t, y, z, sum, k[0]);
+            y = x - t;
+            v.Store(0, y);
+        }
+    }
+};
+
+/**
+ * @brief XxteaContext
+ * @details Key schedule of XXTEA expanded once from a 128-bit key, to be reused across calls
+ */
+class XxteaContext {
+public:
+    /**
+     * @param key Any 128-bit block
+     * @param order Byte order of the words of the data
+     */
+    explicit XxteaContext(const uint32_t key[4], ByteOrder order = ByteOrder::Little) noexcept
+        : order_(order) {
+        Xxtea::ExpandKey(key, schedule_);
+    }
+
+    /**
+     * @param key Pointer to any 128-bit block
+     * @param order Byte order of the words of the key and of the data
+     */
+    explicit XxteaContext(const uchar* key, ByteOrder order = ByteOrder::Little) noexcept
+        : XxteaContext(Detail::Key(key, order).w, order) {}
+
+#ifdef QT_CORE_LIB
+    /**
+     * @param key Any bytearray of 128 bit long
+     * @param order Byte order of the words of the key and of the data
+     */
+    explicit XxteaContext(const QByteArray& key, ByteOrder order = ByteOrder::Little) noexcept
+        : XxteaContext((const uchar*)key.constData(), order) {}
+#endif /* ifdef(QT_CORE_LIB) */
+
+    /**
+     * @brief Order
+     * @return Byte order of the data
+     */
+    ByteOrder Order() const noexcept { return order_; }
+
+    const Detail::XxteaSchedule& KeySchedule() const noexcept { return schedule_; }
+
+private:
+    Detail::XxteaSchedule schedule_;
+    ByteOrder order_;
+};
+
+/**
+ * @brief EncipherBlock
+ * @details XXTEA over a block of any number of words
+ * @param v Words of the block to encipher
+ * @param n_words Number of words, at least 2
+ * @param ctx Expanded key
+ * @return false if n_words is less than 2, in which case v is left as it is
+ */
+inline bool EncipherBlock(uint32_t v[], size_t n_words, const XxteaContext& ctx) noexcept {
+    if (n_words < 2) return false;
+    Xxtea::Encipher(Detail::LaneWords<uint32_t>{ v }, n_words, ctx.KeySchedule());
+    return true;
+}
+
+/**
+ * @brief DecipherBlock
+ * @param v Words of the block to decipher
+ * @param n_words Number of words which was enciphered
+ * @param ctx Expanded key which was used to encipher
+ * @return false if n_words is less than 2, in which case v is left as it is
+ */
+inline bool DecipherBlock(uint32_t v[], size_t n_words, const XxteaContext& ctx) noexcept {
+    if (n_words < 2) return false;
+    Xxtea::Decipher(Detail::LaneWords<uint32_t>{ v }, n_words, ctx.KeySchedule());
+    return true;
+}
+
+/**
+ * @brief Kernel
+ * @details Implementations of the bulk block loop used by Encrypt and Decrypt.
+ * Kernel::Bitsliced is never chosen automatically and has to be selected explicitly
+ */
+enum class Kernel {
+    Auto,
+    Scalar,
+    Sse2,
+    Avx2,
+    Avx512,
+    Bitsliced
+};
+
+namespace Detail {
+
+#if defined(__clang__) || (__GNUC__ >= 12)
+#define XTEA_SHUFFLE(V, a, b, ...) __builtin_shufflevector(a, b, __VA_ARGS__)
+#else
+#define XTEA_SHUFFLE(V, a, b, ...) __builtin_shuffle(a, b, (V){__VA_ARGS__})
+#endif
+
+#ifdef XTEA_HAS_X86_SIMD
+typedef uint32_t U32x4 __attribute__((vector_size(16)));
+typedef uint32_t U32x8 __attribute__((vector_size(32)));
+typedef uint32_t U32x16 __attribute__((vector_size(64)));
+
+/**
+ * @brief SwapBytes
+ * @details With AVX2 a single vpshufb. SSE2 has no byte shuffle and AVX-512F none
+ * without AVX512BW, so U32x4 and U32x16 take the generic shifts and masks
+ */
+XTEA_TARGET("avx2") inline void SwapBytes(U32x8& x) noexcept {
+    const __m256i m = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                       3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    x = (U32x8)_mm256_shuffle_epi8((__m256i)x, m);
+}
+
+/**
+ * @brief FromOrder
+ * @details Converts words between the byte order Order and the (little-endian) host order
+ */
+template<ByteOrder Order, class V>
+XTEA_FORCEINLINE void FromOrder(V& x) noexcept {
+    if (Order == ByteOrder::Big) SwapBytes(x);
+}
+
+/**
+ * @brief LoadBlocks
+ * @details Loads one block per lane and transposes them into
+ * a vector of first halves (v0) and a vector of second halves (v1).
+ * x86 is little-endian, so only big-endian words are byte swapped, in register
+ */
+template<ByteOrder Order>
+inline void LoadBlocks(const uchar* p, U32x4& v0, U32x4& v1) noexcept {
+    U32x4 a, b;
+    memcpy(&a, p, sizeof(a));
+    memcpy(&b, p + sizeof(a), sizeof(b));
+    FromOrder<Order>(a);
+    FromOrder<Order>(b);
+    v0 = XTEA_SHUFFLE(U32x4, a, b, 0, 2, 4, 6);
+    v1 = XTEA_SHUFFLE(U32x4, a, b, 1, 3, 5, 7);
+}
+
+/**
+ * @brief StoreBlocks
+ * @details Inverse of LoadBlocks
+ */
+template<ByteOrder Order>
+inline void StoreBlocks(uchar* p, const U32x4& v0, const U32x4& v1) noexcept {
+    U32x4 a = XTEA_SHUFFLE(U32x4, v0, v1, 0, 4, 1, 5);
+    U32x4 b = XTEA_SHUFFLE(U32x4, v0, v1, 2, 6, 3, 7);
+    FromOrder<Order>(a);
+    FromOrder<Order>(b);
+    memcpy(p, &a, sizeof(a));
+    memcpy(p + sizeof(a), &b, sizeof(b));
+}
+
+template<ByteOrder Order>
+inline void LoadBlocks(const uchar* p, U32x8& v0, U32x8& v1) noexcept {
+    U32x8 a, b;
+    memcpy(&a, p, sizeof(a));
+    memcpy(&b, p + sizeof(a), sizeof(b));
+    FromOrder<Order>(a);
+    FromOrder<Order>(b);
+    v0 = XTEA_SHUFFLE(U32x8, a, b, 0, 2, 4, 6, 8, 10, 12, 14);
+    v1 = XTEA_SHUFFLE(U32x8, a, b, 1, 3, 5, 7, 9, 11, 13, 15);
+}
+
+template<ByteOrder Order>
+inline void StoreBlocks(uchar* p, const U32x8& v0, const U32x8& v1) noexcept {
+    U32x8 a = XTEA_SHUFFLE(U32x8, v0, v1, 0, 8, 1, 9, 2, 10, 3, 11);
+    U32x8 b = XTEA_SHUFFLE(U32x8, v0, v1, 4, 12, 5, 13, 6, 14, 7, 15);
+    FromOrder<Order>(a);
+    FromOrder<Order>(b);
+    memcpy(p, &a, sizeof(a));
+    memcpy(p + sizeof(a), &b, sizeof(b));
+}
+
+template<ByteOrder Order>
+inline void LoadBlocks(const uchar* p, U32x16& v0, U32x16& v1) noexcept {
+    U32x16 a, b;
+    memcpy(&a, p, sizeof(a));
+    memcpy(&b, p + sizeof(a), sizeof(b));
+    FromOrder<Order>(a);
+    FromOrder<Order>(b);
+    v0 = XTEA_SHUFFLE(U32x16, a, b, 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    v1 = XTEA_SHUFFLE(U32x16, a, b, 1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+}
+
+template<ByteOrder Order>
+inline void StoreBlocks(uchar* p, const U32x16& v0, const U32x16& v1) noexcept {
+    U32x16 a = XTEA_SHUFFLE(U32x16, v0, v1, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    U32x16 b = XTEA_SHUFFLE(U32x16, v0, v1, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    FromOrder<Order>(a);
+    FromOrder<Order>(b);
+    memcpy(p, &a, sizeof(a));
+    memcpy(p + sizeof(a), &b, sizeof(b));
+}
+
+/**
+ * @brief WordMask
+ * @details Mask register selecting the first n_words (clamped to 0..16) 32-bit lanes
+ */
+XTEA_TARGET("avx512f") inline __mmask16 WordMask(ptrdiff_t n_words) noexcept {
+    return n_words >= 16 ? (__mmask16)0xFFFF : n_words <= 0 ? (__mmask16)0 : (__mmask16)((1u << n_words) - 1);
+}
+
+/**
+ * @brief LoadBlocksMasked
+ * @details Same as LoadBlocks for the first n_blocks (at most 16) blocks.
+ * Bytes past the last block are neither read nor faulted on
+ */
+template<ByteOrder Order>
+XTEA_TARGET("avx512f") inline void LoadBlocksMasked(const uchar* p, size_t n_blocks, U32x16& v0, U32x16& v1) noexcept {
+    ptrdiff_t n_words = (ptrdiff_t)(2 * n_blocks);
+    U32x16 a = (U32x16)_mm512_maskz_loadu_epi32(WordMask(n_words), p);
+    U32x16 b = (U32x16)_mm512_maskz_loadu_epi32(WordMask(n_words - 16), p + sizeof(a));
+    FromOrder<Order>(a);
+    FromOrder<Order>(b);
+    v0 = XTEA_SHUFFLE(U32x16, a, b, 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    v1 = XTEA_SHUFFLE(U32x16, a, b, 1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+}
+
+/**
+ * @brief StoreBlocksMasked
+ * @details Inverse of LoadBlocksMasked
+ */
+template<ByteOrder Order>
+XTEA_TARGET("avx512f") inline void StoreBlocksMasked(uchar* p, size_t n_blocks, const U32x16& v0, const U32x16& v1) noexcept {
+    ptrdiff_t n_words = (ptrdiff_t)(2 * n_blocks);
+    U32x16 a = XTEA_SHUFFLE(U32x16, v0, v1, 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    U32x16 b = XTEA_SHUFFLE(U32x16, v0, v1, 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    FromOrder<Order>(a);
+    FromOrder<Order>(b);
+    _mm512_mask_storeu_epi32(p, WordMask(n_words), (__m512i)a);
+    _mm512_mask_storeu_epi32(p + sizeof(a), WordMask(n_words - 16), (__m512i)b);
+}
+#endif /* ifdef(XTEA_HAS_X86_SIMD) */
+
+/**
+ * @brief Number of vector groups interleaved per iteration of the SIMD kernels
+ */
+constexpr const uint SIMD_GROUPS = 2;
+
+/**
+ * @brief EncipherBlocks
+ * @details Enciphers as many whole groups of blocks as fit in n_blocks
+ * using lane type V and returns the number of blocks processed. The byte
+ * order is a template argument so the swap, if any, is folded into the loads
+ * and stores; the overload without it picks it from the schedule once per call
+ */
+template<class V, uint Rounds, class Cipher, ByteOrder Order>
+inline size_t EncipherBlocks(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    const size_t step = SIMD_GROUPS * sizeof(V) / sizeof(uint32_t);
+    size_t i = 0;
+    for (; i + step <= n_blocks; i += step) {
+        V v0[SIMD_GROUPS], v1[SIMD_GROUPS];
+        for (uint g = 0; g < SIMD_GROUPS; g++) LoadBlocks<Order>(src + BLOCK_SIZE * i + 2 * sizeof(V) * g, v0[g], v1[g]);
+        LaneRounds<Cipher, Rounds>::template Encipher<SIMD_GROUPS>(v0, v1, s);
+        for (uint g = 0; g < SIMD_GROUPS; g++) StoreBlocks<Order>(dst + BLOCK_SIZE * i + 2 * sizeof(V) * g, v0[g], v1[g]);
+    }
+    return i;
+}
+
+template<class V, uint Rounds>
+inline size_t EncipherBlocks(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    if (s.algorithm == Algorithm::Tea) {
+        if (s.order == ByteOrder::Big) return EncipherBlocks<V, Rounds, Tea, ByteOrder::Big>(src, dst, n_blocks, s);
+        return EncipherBlocks<V, Rounds, Tea, ByteOrder::Little>(src, dst, n_blocks, s);
+    }
+    if (s.order == ByteOrder::Big) return EncipherBlocks<V, Rounds, Xtea, ByteOrder::Big>(src, dst, n_blocks, s);
+    return EncipherBlocks<V, Rounds, Xtea, ByteOrder::Little>(src, dst, n_blocks, s);
+}
+
+/**
+ * @brief DecipherBlocks
+ * @details Counterpart of EncipherBlocks
+ */
+template<class V, uint Rounds, class Cipher, ByteOrder Order>
+inline size_t DecipherBlocks(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    const size_t step = SIMD_GROUPS * sizeof(V) / sizeof(uint32_t);
+    size_t i = 0;
+    for (; i + step <= n_blocks; i += step) {
+        V v0[SIMD_GROUPS], v1[SIMD_GROUPS];
+        for (uint g = 0; g < SIMD_GROUPS; g++) LoadBlocks<Order>(src + BLOCK_SIZE * i + 2 * sizeof(V) * g, v0[g], v1[g]);
+        LaneRounds<Cipher, Rounds>::template Decipher<SIMD_GROUPS>(v0, v1, s);
+        for (uint g = 0; g < SIMD_GROUPS; g++) StoreBlocks<Order>(dst + BLOCK_SIZE * i + 2 * sizeof(V) * g, v0[g], v1[g]);
+    }
+    return i;
+}
+
+template<class V, uint Rounds>
+inline size_t DecipherBlocks(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    if (s.algorithm == Algorithm::Tea) {
+        if (s.order == ByteOrder::Big) return DecipherBlocks<V, Rounds, Tea, ByteOrder::Big>(src, dst, n_blocks, s);
+        return DecipherBlocks<V, Rounds, Tea, ByteOrder::Little>(src, dst, n_blocks, s);
+    }
+    if (s.order == ByteOrder::Big) return DecipherBlocks<V, Rounds, Xtea, ByteOrder::Big>(src, dst, n_blocks, s);
+    return DecipherBlocks<V, Rounds, Xtea, ByteOrder::Little>(src, dst, n_blocks, s);
+}
+
+/**
+ * @brief CtrBlocks
+ * @details XORs the counter mode keystream into as many whole groups of blocks
+ * as fit in n_blocks and returns the number of blocks processed. Block i uses
+ * counter + i, split into its low (v0) and high (v1) 32-bit halves
+ */
+template<class V, uint Rounds, class Cipher, ByteOrder Order>
+inline size_t CtrBlocks(uchar* data, size_t n_blocks, const Schedule& s, uint64_t counter) noexcept {
+    const size_t lanes = sizeof(V) / sizeof(uint32_t);
+    const size_t step = SIMD_GROUPS * lanes;
+    V iota;
+    for (size_t l = 0; l < lanes; l++) iota[l] = (uint32_t)l;
+    size_t i = 0;
+    for (; i + step <= n_blocks; i += step) {
+        V v0[SIMD_GROUPS], v1[SIMD_GROUPS];
+        for (uint g = 0; g < SIMD_GROUPS; g++) {
+            uint64_t c = counter + i + lanes * g;
+            v0[g] = iota + (uint32_t)c;
+            v1[g] = (uint32_t)(c >> 32) - (V)(v0[g] < (uint32_t)c);
+        }
+        LaneRounds<Cipher, Rounds>::template Encipher<SIMD_GROUPS>(v0, v1, s);
+        for (uint g = 0; g < SIMD_GROUPS; g++) {
+            uchar* p = data + BLOCK_SIZE * i + 2 * sizeof(V) * g;
+            V d0, d1;
+            LoadBlocks<Order>(p, d0, d1);
+            StoreBlocks<Order>(p, d0 ^ v0[g], d1 ^ v1[g]);
+        }
+    }
+    return i;
+}
+
+template<class V, uint Rounds>
+inline size_t CtrBlocks(uchar* data, size_t n_blocks, const Schedule& s, uint64_t counter) noexcept {
+    if (s.algorithm == Algorithm::Tea) {
+        if (s.order == ByteOrder::Big) return CtrBlocks<V, Rounds, Tea, ByteOrder::Big>(data, n_blocks, s, counter);
+        return CtrBlocks<V, Rounds, Tea, ByteOrder::Little>(data, n_blocks, s, counter);
+    }
+    if (s.order == ByteOrder::Big) return CtrBlocks<V, Rounds, Xtea, ByteOrder::Big>(data, n_blocks, s, counter);
+    return CtrBlocks<V, Rounds, Xtea, ByteOrder::Little>(data, n_blocks, s, counter);
+}
+
+/**
+ * @brief MULTI_LANES
+ * @details Number of independent blocks, each under its own key, enciphered by one
+ * call of a multi-key kernel. Lane l of word w of the keys is at key[MULTI_LANES * w + l]
+ */
+constexpr const uint MULTI_LANES = 16;
+
+/**
+ * @brief EncipherMulti
+ * @details Enciphers MULTI_LANES blocks, held as their v[0] and v[1] words, under a key per lane
+ */
+template<class V>
+inline void EncipherMulti(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    constexpr uint W = sizeof(V) / sizeof(uint32_t);
+    constexpr uint G = MULTI_LANES / W;
+    V a[G], b[G], k[4 * G];
+    memcpy(a, v0, sizeof(a));
+    memcpy(b, v1, sizeof(b));
+    for (uint g = 0; g < G; g++) {
+        for (uint w = 0; w < 4; w++) memcpy(&k[4 * g + w], key + MULTI_LANES * w + W * g, sizeof(V));
+    }
+    if (algorithm == Algorithm::Tea) Tea::EncipherKeyedLanes<G>(a, b, k, n_rounds);
+    else Xtea::EncipherKeyedLanes<G>(a, b, k, n_rounds);
+    memcpy(v0, a, sizeof(a));
+    memcpy(v1, b, sizeof(b));
+}
+
+/**
+ * @brief DecipherMulti
+ * @details Counterpart of EncipherMulti
+ */
+template<class V>
+inline void DecipherMulti(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    constexpr uint W = sizeof(V) / sizeof(uint32_t);
+    constexpr uint G = MULTI_LANES / W;
+    V a[G], b[G], k[4 * G];
+    memcpy(a, v0, sizeof(a));
+    memcpy(b, v1, sizeof(b));
+    for (uint g = 0; g < G; g++) {
+        for (uint w = 0; w < 4; w++) memcpy(&k[4 * g + w], key + MULTI_LANES * w + W * g, sizeof(V));
+    }
+    if (algorithm == Algorithm::Tea) Tea::DecipherKeyedLanes<G>(a, b, k, n_rounds);
+    else Xtea::DecipherKeyedLanes<G>(a, b, k, n_rounds);
+    memcpy(v0, a, sizeof(a));
+    memcpy(v1, b, sizeof(b));
+}
+
+/**
+ * @brief XxteaLanes
+ * @details Enciphers (or deciphers if Inverse) n_messages XXTEA blocks of n_words words each,
+ * as many at a time as V has lanes: the words of each group are interleaved into
+ * scratch (sizeof(V) / 4 * n_words words), run through the cycles together and
+ * written back. Returns the number of leading messages processed
+ */
+template<class V, bool Inverse, ByteOrder Order>
+inline size_t XxteaLanes(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s, uint32_t* scratch) noexcept {
+    constexpr uint W = sizeof(V) / sizeof(uint32_t);
+    size_t m = 0;
+    for (; m + W <= n_messages; m += W) {
+        for (size_t i = 0; i < n_words; i++) {
+            for (uint l = 0; l < W; l++) scratch[W * i + l] = LoadWord<Order>(data[m + l] + 4 * i);
+        }
+        if (Inverse) Xxtea::Decipher(LaneWords<V>{ scratch }, n_words, s);
+        else Xxtea::Encipher(LaneWords<V>{ scratch }, n_words, s);
+        for (size_t i = 0; i < n_words; i++) {
+            for (uint l = 0; l < W; l++) StoreWord<Order>(data[m + l] + 4 * i, scratch[W * i + l]);
+        }
+    }
+    return m;
+}
+
+template<class V, bool Inverse>
+inline size_t XxteaLanes(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s,
+                         ByteOrder order, uint32_t* scratch) noexcept {
+    if (order == ByteOrder::Big) return XxteaLanes<V, Inverse, ByteOrder::Big>(data, n_messages, n_words, s, scratch);
+    return XxteaLanes<V, Inverse, ByteOrder::Little>(data, n_messages, n_words, s, scratch);
+}
+
+#ifdef XTEA_HAS_X86_SIMD
+/**
+ * @brief EncipherTail
+ * @details Enciphers the last n_blocks (less than one iteration of EncipherBlocks)
+ * with masked loads and stores, so no block is left to the scalar loop
+ */
+template<uint Rounds, class Cipher, ByteOrder Order>
+XTEA_TARGET("avx512f") inline void EncipherTail(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    if (n_blocks == 0) return;
+    const size_t lanes = sizeof(U32x16) / sizeof(uint32_t);
+    U32x16 v0[SIMD_GROUPS], v1[SIMD_GROUPS];
+    for (uint g = 0; g < SIMD_GROUPS; g++) {
+        size_t n = n_blocks > lanes * g ? n_blocks - lanes * g : 0;
+        LoadBlocksMasked<Order>(src + BLOCK_SIZE * lanes * g, n < lanes ? n : lanes, v0[g], v1[g]);
+    }
+    LaneRounds<Cipher, Rounds>::template Encipher<SIMD_GROUPS>(v0, v1, s);
+    for (uint g = 0; g < SIMD_GROUPS; g++) {
+        size_t n = n_blocks > lanes * g ? n_blocks - lanes * g : 0;
+        StoreBlocksMasked<Order>(dst + BLOCK_SIZE * lanes * g, n < lanes ? n : lanes, v0[g], v1[g]);
+    }
+}
+
+template<uint Rounds>
+XTEA_TARGET("avx512f") inline void EncipherTail(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    if (s.algorithm == Algorithm::Tea) {
+        if (s.order == ByteOrder::Big) EncipherTail<Rounds, Tea, ByteOrder::Big>(src, dst, n_blocks, s);
+        else EncipherTail<Rounds, Tea, ByteOrder::Little>(src, dst, n_blocks, s);
+    } else if (s.order == ByteOrder::Big) {
+        EncipherTail<Rounds, Xtea, ByteOrder::Big>(src, dst, n_blocks, s);
+    } else {
+        EncipherTail<Rounds, Xtea, ByteOrder::Little>(src, dst, n_blocks, s);
+    }
+}
+
+/**
+ * @brief DecipherTail
+ * @details Counterpart of EncipherTail
+ */
+template<uint Rounds, class Cipher, ByteOrder Order>
+XTEA_TARGET("avx512f") inline void DecipherTail(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    if (n_blocks == 0) return;
+    const size_t lanes = sizeof(U32x16) / sizeof(uint32_t);
+    U32x16 v0[SIMD_GROUPS], v1[SIMD_GROUPS];
+    for (uint g = 0; g < SIMD_GROUPS; g++) {
+        size_t n = n_blocks > lanes * g ? n_blocks - lanes * g : 0;
+        LoadBlocksMasked<Order>(src + BLOCK_SIZE * lanes * g, n < lanes ? n : lanes, v0[g], v1[g]);
+    }
+    LaneRounds<Cipher, Rounds>::template Decipher<SIMD_GROUPS>(v0, v1, s);
+    for (uint g = 0; g < SIMD_GROUPS; g++) {
+        size_t n = n_blocks > lanes * g ? n_blocks - lanes * g : 0;
+        StoreBlocksMasked<Order>(dst + BLOCK_SIZE * lanes * g, n < lanes ? n : lanes, v0[g], v1[g]);
+    }
+}
+
+template<uint Rounds>
+XTEA_TARGET("avx512f") inline void DecipherTail(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    if (s.algorithm == Algorithm::Tea) {
+        if (s.order == ByteOrder::Big) DecipherTail<Rounds, Tea, ByteOrder::Big>(src, dst, n_blocks, s);
+        else DecipherTail<Rounds, Tea, ByteOrder::Little>(src, dst, n_blocks, s);
+    } else if (s.order == ByteOrder::Big) {
+        DecipherTail<Rounds, Xtea, ByteOrder::Big>(src, dst, n_blocks, s);
+    } else {
+        DecipherTail<Rounds, Xtea, ByteOrder::Little>(src, dst, n_blocks, s);
+    }
+}
+#endif /* ifdef(XTEA_HAS_X86_SIMD) */
+
+/**
+ * Bitsliced engine. A group of 64 blocks per 64-bit lane of P is transposed into
+ * bit planes: plane j of v0 holds bit j of the first half of every block, one block
+ * per bit. Shifts become plane renumbering, XOR with a round constant becomes
+ * conditional inversion and additions become ripple-carry adders over the planes.
+ */
+
+/**
+ * @brief TransposePlanes
+ * @details Transposes the 64x64 bit matrix held in each 64-bit lane of a[].
+ * The transposition is its own inverse
+ */
+template<class P>
+inline void TransposePlanes(P a[64]) noexcept {
+    uint64_t m = 0x00000000FFFFFFFFull;
+    for (uint j = 32; j != 0; j >>= 1, m ^= m << j) {
+        for (uint k = 0; k < 64; k = (k + j + 1) & ~j) {
+            P t = ((a[k] >> j) ^ a[k + j]) & m;
+            a[k] ^= t << j;
+            a[k + j] ^= t;
+        }
+    }
+}
+
+/**
+ * @brief ToPlanes
+ * @details Loads 64 blocks per lane of P and transposes them into bit planes:
+ * a[0..31] are the planes of v0 and a[32..63] the planes of v1
+ */
+template<class P>
+inline void ToPlanes(const uchar* p, P a[64], ByteOrder order) noexcept {
+    const size_t lanes = sizeof(P) / sizeof(uint64_t);
+    for (size_t l = 0; l < lanes; l++) {
+        for (uint k = 0; k < 64; k++) {
+            uint32_t v[2];
+            LoadBlock(v, p + BLOCK_SIZE * (64 * l + k), order);
+            uint64_t row = (uint64_t)v[1] << 32 | v[0];
+            memcpy((uchar*)&a[k] + sizeof(row) * l, &row, sizeof(row));
+        }
+    }
+    TransposePlanes(a);
+}
+
+/**
+ * @brief FromPlanes
+ * @details Inverse of ToPlanes. Clobbers a[]
+ */
+template<class P>
+inline void FromPlanes(uchar* p, P a[64], ByteOrder order) noexcept {
+    const size_t lanes = sizeof(P) / sizeof(uint64_t);
+    TransposePlanes(a);
+    for (size_t l = 0; l < lanes; l++) {
+        for (uint k = 0; k < 64; k++) {
+            uint64_t row;
+            memcpy(&row, (const uchar*)&a[k] + sizeof(row) * l, sizeof(row));
+            uint32_t v[2] = { (uint32_t)row, (uint32_t)(row >> 32) };
+            StoreBlock(p + BLOCK_SIZE * (64 * l + k), v, order);
+        }
+    }
+}
+
+/**
+ * @brief ShiftPlanes
+ * @details r = v << shift for positive shift or v >> -shift otherwise
+ */
+template<class P>
+inline void ShiftPlanes(P r[32], const P v[32], int shift) noexcept {
+    for (int j = 0; j < 32; j++) {
+        int src = j - shift;
+        r[j] = src >= 0 && src < 32 ? v[src] : P();
+    }
+}
+
+/**
+ * @brief AddConstPlanes
+ * @details r = (v shifted by shift) + k
+ */
+template<class P>
+inline void AddConstPlanes(P r[32], const P v[32], int shift, uint32_t k) noexcept {
+    P c = P();
+    ShiftPlanes(r, v, shift);
+    for (int j = 0; j < 32; j++) {
+        P a = r[j];
+        if ((k >> j) & 1) { r[j] = ~(a ^ c); c = a | c; }
+        else              { r[j] = a ^ c;    c = a & c; }
+    }
+}
+
+/**
+ * @brief AddPlanes
+ * @details r += a, or r -= a when Subtract is set
+ */
+template<bool Subtract, class P>
+inline void AddPlanes(P r[32], const P a[32]) noexcept {
+    P c = Subtract ? ~P() : P();
+    for (int j = 0; j < 32; j++) {
+        P b = Subtract ? ~a[j] : a[j];
+        P x = r[j] ^ b;
+        P g = r[j] & b;
+        r[j] = x ^ c;
+        c = g | (c & x);
+    }
+}
+
+/**
+ * @brief XorConstPlanes
+ * @details r ^= k
+ */
+template<class P>
+inline void XorConstPlanes(P r[32], uint32_t k) noexcept {
+    for (int j = 0; j < 32; j++) {
+        if ((k >> j) & 1) r[j] = ~r[j];
+    }
+}
+
+/**
+ * @brief RoundPlanes
+ * @details TEA half-round: t = ((v << 4) + k0) ^ (v + sum) ^ ((v >> 5) + k1)
+ */
+template<class P>
+inline void RoundPlanes(P t[32], const P v[32], uint32_t k0, uint32_t sum, uint32_t k1) noexcept {
+    P x[32], y[32];
+    AddConstPlanes(t, v, 4, k0);
+    AddConstPlanes(x, v, 0, sum);
+    AddConstPlanes(y, v, -5, k1);
+    for (int j = 0; j < 32; j++) t[j] ^= x[j] ^ y[j];
+}
+
+/**
+ * @brief RoundPlanes
+ * @details XTEA half-round: t = (((v << 4) ^ (v >> 5)) + v) ^ k
+ */
+template<class P>
+inline void RoundPlanes(P t[32], const P v[32], uint32_t k) noexcept {
+    P c = P(), s[32];
+    ShiftPlanes(t, v, 4);
+    ShiftPlanes(s, v, -5);
+    for (int j = 0; j < 32; j++) {
+        P a = t[j] ^ s[j];
+        P x = a ^ v[j];
+        t[j] = x ^ c;
+        c = (a & v[j]) | (c & x);
+    }
+    XorConstPlanes(t, k);
+}
+
+} // namespace Detail
+
+template<class P>
+inline void Xtea::EncipherPlanes(P v0[32], P v1[32], const Detail::Schedule& s) noexcept {
+    P t[32];
+    const uint32_t* rk = s.round_keys;
+    for (uint i = 0; i < s.n_rounds; i++, rk += 2) {
+        Detail::RoundPlanes(t, v1, rk[0]);
+        Detail::AddPlanes<false>(v0, t);
+        Detail::RoundPlanes(t, v0, rk[1]);
+        Detail::AddPlanes<false>(v1, t);
+    }
+}
+
+template<class P>
+inline void Xtea::DecipherPlanes(P v0[32], P v1[32], const Detail::Schedule& s) noexcept {
+    P t[32];
+    const uint32_t* rk = s.round_keys;
+    for (uint i = 0; i < s.n_rounds; i++, rk += 2) {
+        Detail::RoundPlanes(t, v0, rk[0]);
+        Detail::AddPlanes<true>(v1, t);
+        Detail::RoundPlanes(t, v1, rk[1]);
+        Detail::AddPlanes<true>(v0, t);
+    }
+}
+
+template<class P>
+inline void Tea::EncipherPlanes(P v0[32], P v1[32], const Detail::Schedule& s) noexcept {
+    P t[32];
+    const uint32_t* key = s.key;
+    const uint32_t* rk = s.round_keys;
+    for (uint i = 0; i < s.n_rounds; i++, rk += 2) {
+        Detail::RoundPlanes(t, v1, key[0], rk[0], key[1]);
+        Detail::AddPlanes<false>(v0, t);
+        Detail::RoundPlanes(t, v0, key[2], rk[1], key[3]);
+        Detail::AddPlanes<false>(v1, t);
+    }
+}
+
+template<class P>
+inline void Tea::DecipherPlanes(P v0[32], P v1[32], const Detail::Schedule& s) noexcept {
+    P t[32];
+    const uint32_t* key = s.key;
+    const uint32_t* rk = s.round_keys;
+    for (uint i = 0; i < s.n_rounds; i++, rk += 2) {
+        Detail::RoundPlanes(t, v0, key[2], rk[0], key[3]);
+        Detail::AddPlanes<true>(v1, t);
+        Detail::RoundPlanes(t, v1, key[0], rk[1], key[1]);
+        Detail::AddPlanes<true>(v0, t);
+    }
+}
+
+namespace Detail {
+
+/**
+ * @brief EncipherBitsliced
+ * @details Enciphers whole groups of 64 blocks per lane of P
+ * and returns the number of blocks processed
+ */
+template<class P>
+inline size_t EncipherBitsliced(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    const size_t step = 64 * sizeof(P) / sizeof(uint64_t);
+    size_t i = 0;
+    for (; i + step <= n_blocks; i += step) {
+        P a[64];
+        ToPlanes(src + BLOCK_SIZE * i, a, s.order);
+        if (s.algorithm == Algorithm::Tea) Tea::EncipherPlanes(a, a + 32, s);
+        else Xtea::EncipherPlanes(a, a + 32, s);
+        FromPlanes(dst + BLOCK_SIZE * i, a, s.order);
+    }
+    return i;
+}
+
+/**
+ * @brief DecipherBitsliced
+ * @details Counterpart of EncipherBitsliced
+ */
+template<class P>
+inline size_t DecipherBitsliced(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    const size_t step = 64 * sizeof(P) / sizeof(uint64_t);
+    size_t i = 0;
+    for (; i + step <= n_blocks; i += step) {
+        P a[64];
+        ToPlanes(src + BLOCK_SIZE * i, a, s.order);
+        if (s.algorithm == Algorithm::Tea) Tea::DecipherPlanes(a, a + 32, s);
+        else Xtea::DecipherPlanes(a, a + 32, s);
+        FromPlanes(dst + BLOCK_SIZE * i, a, s.order);
+    }
+    return i;
+}
+
+/**
+ * Number of blocks the portable kernel processes together. More than 16, since
+ * at -O3 GCC completely unrolls loops of up to 16 iterations before the loop
+ * vectorizer runs, and the unrolled rounds then vectorize poorly
+ */
+constexpr const size_t SCALAR_BATCH = 32;
+
+/**
+ * @brief EncipherBulkScalar
+ * @details Portable kernel: SCALAR_BATCH blocks are loaded into word arrays and
+ * every round runs over the whole batch, the innermost loop being over blocks,
+ * which the compiler can auto-vectorize (GCC 12 and later do so from -O2 on)
+ */
+template<uint Rounds, class Cipher, ByteOrder Order>
+inline size_t EncipherBulkScalar(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    size_t i = 0;
+    for (; i + SCALAR_BATCH <= n_blocks; i += SCALAR_BATCH) {
+        uint32_t v0[SCALAR_BATCH], v1[SCALAR_BATCH];
+        for (size_t j = 0; j < SCALAR_BATCH; j++) {
+            v0[j] = LoadWord<Order>(src + BLOCK_SIZE * (i + j));
+            v1[j] = LoadWord<Order>(src + BLOCK_SIZE * (i + j) + 4);
+        }
+        LaneRounds<Cipher, Rounds>::template Encipher<SCALAR_BATCH>(v0, v1, s);
+        for (size_t j = 0; j < SCALAR_BATCH; j++) {
+            StoreWord<Order>(dst + BLOCK_SIZE * (i + j), v0[j]);
+            StoreWord<Order>(dst + BLOCK_SIZE * (i + j) + 4, v1[j]);
+        }
+    }
+    return i;
+}
+
+template<uint Rounds>
+inline size_t EncipherBulkScalar(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    if (s.algorithm == Algorithm::Tea) {
+        if (s.order == ByteOrder::Big) return EncipherBulkScalar<Rounds, Tea, ByteOrder::Big>(src, dst, n_blocks, s);
+        return EncipherBulkScalar<Rounds, Tea, ByteOrder::Little>(src, dst, n_blocks, s);
+    }
+    if (s.order == ByteOrder::Big) return EncipherBulkScalar<Rounds, Xtea, ByteOrder::Big>(src, dst, n_blocks, s);
+    return EncipherBulkScalar<Rounds, Xtea, ByteOrder::Little>(src, dst, n_blocks, s);
+}
+
+/**
+ * @brief DecipherBulkScalar
+ * @details Counterpart of EncipherBulkScalar
+ */
+template<uint Rounds, class Cipher, ByteOrder Order>
+inline size_t DecipherBulkScalar(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    size_t i = 0;
+    for (; i + SCALAR_BATCH <= n_blocks; i += SCALAR_BATCH) {
+        uint32_t v0[SCALAR_BATCH], v1[SCALAR_BATCH];
+        for (size_t j = 0; j < SCALAR_BATCH; j++) {
+            v0[j] = LoadWord<Order>(src + BLOCK_SIZE * (i + j));
+            v1[j] = LoadWord<Order>(src + BLOCK_SIZE * (i + j) + 4);
+        }
+        LaneRounds<Cipher, Rounds>::template Decipher<SCALAR_BATCH>(v0, v1, s);
+        for (size_t j = 0; j < SCALAR_BATCH; j++) {
+            StoreWord<Order>(dst + BLOCK_SIZE * (i + j), v0[j]);
+            StoreWord<Order>(dst + BLOCK_SIZE * (i + j) + 4, v1[j]);
+        }
+    }
+    return i;
+}
+
+template<uint Rounds>
+inline size_t DecipherBulkScalar(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    if (s.algorithm == Algorithm::Tea) {
+        if (s.order == ByteOrder::Big) return DecipherBulkScalar<Rounds, Tea, ByteOrder::Big>(src, dst, n_blocks, s);
+        return DecipherBulkScalar<Rounds, Tea, ByteOrder::Little>(src, dst, n_blocks, s);
+    }
+    if (s.order == ByteOrder::Big) return DecipherBulkScalar<Rounds, Xtea, ByteOrder::Big>(src, dst, n_blocks, s);
+    return DecipherBulkScalar<Rounds, Xtea, ByteOrder::Little>(src, dst, n_blocks, s);
+}
+
+inline size_t CtrScalar(uchar*, size_t, const Schedule&, uint64_t) noexcept {
+    return 0;
+}
+
+inline size_t XxteaScalar(uchar* const[], size_t, size_t, const XxteaSchedule&, ByteOrder, uint32_t*) noexcept {
+    return 0;
+}
+
+inline void EncipherMultiScalar(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    EncipherMulti<uint32_t>(v0, v1, key, n_rounds, algorithm);
+}
+
+inline void DecipherMultiScalar(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    DecipherMulti<uint32_t>(v0, v1, key, n_rounds, algorithm);
+}
+
+inline size_t EncipherBulkBitsliced(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return EncipherBitsliced<uint64_t>(src, dst, n_blocks, s);
+}
+
+inline size_t DecipherBulkBitsliced(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return DecipherBitsliced<uint64_t>(src, dst, n_blocks, s);
+}
+
+#ifdef XTEA_HAS_X86_SIMD
+/**
+ * @brief EncipherBulkSse2
+ * @details Kernel entry points. Each one is flattened so the lane templates
+ * are inlined and compiled for the entry's instruction set. They return the
+ * number of leading blocks processed; the rest is left to the scalar loop.
+ * Rounds is the number of rounds when known at compile time, 0 otherwise
+ */
+template<uint Rounds>
+XTEA_TARGET("sse2") inline size_t EncipherBulkSse2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return EncipherBlocks<U32x4, Rounds>(src, dst, n_blocks, s);
+}
+
+template<uint Rounds>
+XTEA_TARGET("sse2") inline size_t DecipherBulkSse2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return DecipherBlocks<U32x4, Rounds>(src, dst, n_blocks, s);
+}
+
+template<uint Rounds>
+XTEA_TARGET("sse2") inline size_t CtrBulkSse2(uchar* data, size_t n_blocks, const Schedule& s, uint64_t counter) noexcept {
+    return CtrBlocks<U32x4, Rounds>(data, n_blocks, s, counter);
+}
+
+XTEA_TARGET("sse2") inline void EncipherMultiSse2(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    EncipherMulti<U32x4>(v0, v1, key, n_rounds, algorithm);
+}
+
+XTEA_TARGET("sse2") inline void DecipherMultiSse2(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    DecipherMulti<U32x4>(v0, v1, key, n_rounds, algorithm);
+}
+
+XTEA_TARGET("sse2") inline size_t EncipherXxteaSse2(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s,
+                                               ByteOrder order, uint32_t* scratch) noexcept {
+    return XxteaLanes<U32x4, false>(data, n_messages, n_words, s, order, scratch);
+}
+
+XTEA_TARGET("sse2") inline size_t DecipherXxteaSse2(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s,
+                                               ByteOrder order, uint32_t* scratch) noexcept {
+    return XxteaLanes<U32x4, true>(data, n_messages, n_words, s, order, scratch);
+}
+
+template<uint Rounds>
+XTEA_TARGET("avx2") inline size_t EncipherBulkAvx2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return EncipherBlocks<U32x8, Rounds>(src, dst, n_blocks, s);
+}
+
+template<uint Rounds>
+XTEA_TARGET("avx2") inline size_t DecipherBulkAvx2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return DecipherBlocks<U32x8, Rounds>(src, dst, n_blocks, s);
+}
+
+template<uint Rounds>
+XTEA_TARGET("avx2") inline size_t CtrBulkAvx2(uchar* data, size_t n_blocks, const Schedule& s, uint64_t counter) noexcept {
+    return CtrBlocks<U32x8, Rounds>(data, n_blocks, s, counter);
+}
+
+XTEA_TARGET("avx2") inline void EncipherMultiAvx2(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    EncipherMulti<U32x8>(v0, v1, key, n_rounds, algorithm);
+}
+
+XTEA_TARGET("avx2") inline void DecipherMultiAvx2(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    DecipherMulti<U32x8>(v0, v1, key, n_rounds, algorithm);
+}
+
+XTEA_TARGET("avx2") inline size_t EncipherXxteaAvx2(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s,
+                                               ByteOrder order, uint32_t* scratch) noexcept {
+    return XxteaLanes<U32x8, false>(data, n_messages, n_words, s, order, scratch);
+}
+
+XTEA_TARGET("avx2") inline size_t DecipherXxteaAvx2(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s,
+                                               ByteOrder order, uint32_t* scratch) noexcept {
+    return XxteaLanes<U32x8, true>(data, n_messages, n_words, s, order, scratch);
+}
+
+template<uint Rounds>
+XTEA_TARGET("avx512f") inline size_t EncipherBulkAvx512(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    size_t i = EncipherBlocks<U32x16, Rounds>(src, dst, n_blocks, s);
+    EncipherTail<Rounds>(src + BLOCK_SIZE * i, dst + BLOCK_SIZE * i, n_blocks - i, s);
+    return n_blocks;
+}
+
+template<uint Rounds>
+XTEA_TARGET("avx512f") inline size_t DecipherBulkAvx512(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    size_t i = DecipherBlocks<U32x16, Rounds>(src, dst, n_blocks, s);
+    DecipherTail<Rounds>(src + BLOCK_SIZE * i, dst + BLOCK_SIZE * i, n_blocks - i, s);
+    return n_blocks;
+}
+
+template<uint Rounds>
+XTEA_TARGET("avx512f") inline size_t CtrBulkAvx512(uchar* data, size_t n_blocks, const Schedule& s, uint64_t counter) noexcept {
+    return CtrBlocks<U32x16, Rounds>(data, n_blocks, s, counter);
+}
+
+XTEA_TARGET("avx512f") inline void EncipherMultiAvx512(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    EncipherMulti<U32x16>(v0, v1, key, n_rounds, algorithm);
+}
+
+XTEA_TARGET("avx512f") inline void DecipherMultiAvx512(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm) noexcept {
+    DecipherMulti<U32x16>(v0, v1, key, n_rounds, algorithm);
+}
+
+XTEA_TARGET("avx512f") inline size_t EncipherXxteaAvx512(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s,
+                                               ByteOrder order, uint32_t* scratch) noexcept {
+    return XxteaLanes<U32x16, false>(data, n_messages, n_words, s, order, scratch);
+}
+
+XTEA_TARGET("avx512f") inline size_t DecipherXxteaAvx512(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s,
+                                               ByteOrder order, uint32_t* scratch) noexcept {
+    return XxteaLanes<U32x16, true>(data, n_messages, n_words, s, order, scratch);
+}
+
+/**
+ * @brief EncipherXteaSse2
+ * @details XTEA-only entry points of Encrypt<Rounds> and Decrypt<Rounds>,
+ * so a compile-time round count does not instantiate TEA and CTR lanes too
+ */
+template<uint Rounds, ByteOrder Order>
+XTEA_TARGET("sse2") inline size_t EncipherXteaSse2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return EncipherBlocks<U32x4, Rounds, Xtea, Order>(src, dst, n_blocks, s);
+}
+
+template<uint Rounds, ByteOrder Order>
+XTEA_TARGET("sse2") inline size_t DecipherXteaSse2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return DecipherBlocks<U32x4, Rounds, Xtea, Order>(src, dst, n_blocks, s);
+}
+
+template<uint Rounds, ByteOrder Order>
+XTEA_TARGET("avx2") inline size_t EncipherXteaAvx2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return EncipherBlocks<U32x8, Rounds, Xtea, Order>(src, dst, n_blocks, s);
+}
+
+template<uint Rounds, ByteOrder Order>
+XTEA_TARGET("avx2") inline size_t DecipherXteaAvx2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return DecipherBlocks<U32x8, Rounds, Xtea, Order>(src, dst, n_blocks, s);
+}
+
+template<uint Rounds, ByteOrder Order>
+XTEA_TARGET("avx512f") inline size_t EncipherXteaAvx512(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    size_t i = EncipherBlocks<U32x16, Rounds, Xtea, Order>(src, dst, n_blocks, s);
+    EncipherTail<Rounds, Xtea, Order>(src + BLOCK_SIZE * i, dst + BLOCK_SIZE * i, n_blocks - i, s);
+    return n_blocks;
+}
+
+template<uint Rounds, ByteOrder Order>
+XTEA_TARGET("avx512f") inline size_t DecipherXteaAvx512(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    size_t i = DecipherBlocks<U32x16, Rounds, Xtea, Order>(src, dst, n_blocks, s);
+    DecipherTail<Rounds, Xtea, Order>(src + BLOCK_SIZE * i, dst + BLOCK_SIZE * i, n_blocks - i, s);
+    return n_blocks;
+}
+
+typedef uint64_t U64x4 __attribute__((vector_size(32)));
+
+/**
+ * @brief EncipherBulkBitslicedAvx2
+ * @details Bitsliced engine with 256 blocks per pass
+ */
+XTEA_TARGET("avx2") inline size_t EncipherBulkBitslicedAvx2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return EncipherBitsliced<U64x4>(src, dst, n_blocks, s);
+}
+
+XTEA_TARGET("avx2") inline size_t DecipherBulkBitslicedAvx2(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s) noexcept {
+    return DecipherBitsliced<U64x4>(src, dst, n_blocks, s);
+}
+#endif /* ifdef(XTEA_HAS_X86_SIMD) */
+
+typedef size_t (*BulkFn)(const uchar* src, uchar* dst, size_t n_blocks, const Schedule& s);
+typedef size_t (*CtrFn)(uchar* data, size_t n_blocks, const Schedule& s, uint64_t counter);
+typedef void (*MultiFn)(uint32_t v0[], uint32_t v1[], const uint32_t key[], uint n_rounds, Algorithm algorithm);
+typedef size_t (*XxteaFn)(uchar* const data[], size_t n_messages, size_t n_words, const XxteaSchedule& s,
+                          ByteOrder order, uint32_t* scratch);
+
+/**
+ * @brief KernelTable
+ * @details Function pointers of the selected kernel
+ */
+struct KernelTable {
+    Kernel kernel;
+    BulkFn encipher;
+    BulkFn decipher;
+    CtrFn ctr;
+    MultiFn encipher_multi;
+    MultiFn decipher_multi;
+    XxteaFn encipher_xxtea;
+    XxteaFn decipher_xxtea;
+};
+
+/**
+ * @brief IsSupported
+ * @return Whether the running CPU can execute the kernel
+ */
+inline bool IsSupported(Kernel kernel) noexcept {
+#ifdef XTEA_HAS_X86_SIMD
+    __builtin_cpu_init();
+    switch (kernel) {
+    case Kernel::Scalar: return true;
+    case Kernel::Sse2:   return __builtin_cpu_supports("sse2");
+    case Kernel::Avx2:   return __builtin_cpu_supports("avx2");
+    case Kernel::Avx512: return __builtin_cpu_supports("avx512f");
+    case Kernel::Bitsliced: return true;
+    default:             return false;
+    }
+#else
+    return kernel == Kernel::Scalar || kernel == Kernel::Bitsliced;
+#endif
+}
+
+/**
+ * @brief ResolveKernel
+ * @param kernel Kernel to use. Kernel::Auto or an unsupported kernel selects the best supported one
+ * @return Kernel the running CPU can execute
+ */
+inline Kernel ResolveKernel(Kernel kernel) noexcept {
+    if (kernel != Kernel::Auto && IsSupported(kernel)) return kernel;
+    const Kernel preference[] = { Kernel::Avx512, Kernel::Avx2, Kernel::Sse2 };
+    for (Kernel k : preference) {
+        if (IsSupported(k)) return k;
+    }
+    return Kernel::Scalar;
+}
+
+/**
+ * @brief MakeKernelTable
+ * @tparam Rounds Number of rounds when known at compile time, 0 otherwise
+ * @param kernel Kernel as returned by ResolveKernel
+ */
+template<uint Rounds = 0>
+inline KernelTable MakeKernelTable(Kernel kernel) noexcept {
+    switch (kernel) {
+#ifdef XTEA_HAS_X86_SIMD
+    case Kernel::Sse2:   return { kernel, EncipherBulkSse2<Rounds>, DecipherBulkSse2<Rounds>, CtrBulkSse2<Rounds>, EncipherMultiSse2, DecipherMultiSse2,
+                                  EncipherXxteaSse2, DecipherXxteaSse2 };
+    case Kernel::Avx2:   return { kernel, EncipherBulkAvx2<Rounds>, DecipherBulkAvx2<Rounds>, CtrBulkAvx2<Rounds>, EncipherMultiAvx2, DecipherMultiAvx2,
+                                  EncipherXxteaAvx2, DecipherXxteaAvx2 };
+    case Kernel::Avx512: return { kernel, EncipherBulkAvx512<Rounds>, DecipherBulkAvx512<Rounds>, CtrBulkAvx512<Rounds>, EncipherMultiAvx512, DecipherMultiAvx512,
+                                  EncipherXxteaAvx512, DecipherXxteaAvx512 };
+    case Kernel::Bitsliced:
+        if (IsSupported(Kernel::Avx2)) return { kernel, EncipherBulkBitslicedAvx2, DecipherBulkBitslicedAvx2, CtrScalar, EncipherMultiScalar, DecipherMultiScalar,
+                                                XxteaScalar, XxteaScalar };
+        return { kernel, EncipherBulkBitsliced, DecipherBulkBitsliced, CtrScalar, EncipherMultiScalar, DecipherMultiScalar, XxteaScalar, XxteaScalar };
+#else
+    case Kernel::Bitsliced: return { kernel, EncipherBulkBitsliced, DecipherBulkBitsliced, CtrScalar, EncipherMultiScalar, DecipherMultiScalar,
+                                     XxteaScalar, XxteaScalar };
+#endif
+    default:             return { Kernel::Scalar, EncipherBulkScalar<Rounds>, DecipherBulkScalar<Rounds>, CtrScalar, EncipherMultiScalar, DecipherMultiScalar,
+                                  XxteaScalar, XxteaScalar };
+    }
+}
+
+/**
+ * @brief KernelFromEnvironment
+ * @details Reads the XTEA_KERNEL environment variable
+ * (scalar, sse2, avx2, avx512 or bitsliced); anything else means Kernel::Auto
+ */
+inline Kernel KernelFromEnvironment() noexcept {
+    const char* name = getenv("XTEA_KERNEL");
+    if (!name) return Kernel::Auto;
+    if (!strcmp(name, "scalar")) return Kernel::Scalar;
+    if (!strcmp(name, "sse2"))   return Kernel::Sse2;
+    if (!strcmp(name, "avx2"))   return Kernel::Avx2;
+    if (!strcmp(name, "avx512")) return Kernel::Avx512;
+    if (!strcmp(name, "bitsliced")) return Kernel::Bitsliced;
+    return Kernel::Auto;
+}
+
+/**
+ * @brief Kernels
+ * @details Table resolved on first use, so the per-call cost of dispatch
+ * is a single indirect call outside of the block loop
+ */
+inline KernelTable& Kernels() noexcept {
+    static KernelTable table = MakeKernelTable(ResolveKernel(KernelFromEnvironment()));
+    return table;
+}
+
+/**
+ * @brief UnrolledEncipher
+ * @details Bulk entry of Encrypt<Rounds> for the given kernel and byte order.
+ * Only the XTEA lanes are unrolled; the bitsliced kernel keeps its runtime entry
+ */
+template<uint Rounds, ByteOrder Order>
+inline BulkFn UnrolledEncipher(Kernel kernel) noexcept {
+    switch (kernel) {
+#ifdef XTEA_HAS_X86_SIMD
+    case Kernel::Sse2:      return EncipherXteaSse2<Rounds, Order>;
+    case Kernel::Avx2:      return EncipherXteaAvx2<Rounds, Order>;
+    case Kernel::Avx512:    return EncipherXteaAvx512<Rounds, Order>;
+#endif
+    case Kernel::Bitsliced: return Kernels().encipher;
+    default:                return EncipherBulkScalar<Rounds, Xtea, Order>;
+    }
+}
+
+/**
+ * @brief UnrolledDecipher
+ * @details Counterpart of UnrolledEncipher for Decrypt<Rounds>
+ */
+template<uint Rounds, ByteOrder Order>
+inline BulkFn UnrolledDecipher(Kernel kernel) noexcept {
+    switch (kernel) {
+#ifdef XTEA_HAS_X86_SIMD
+    case Kernel::Sse2:      return DecipherXteaSse2<Rounds, Order>;
+    case Kernel::Avx2:      return DecipherXteaAvx2<Rounds, Order>;
+    case Kernel::Avx512:    return DecipherXteaAvx512<Rounds, Order>;
+#endif
+    case Kernel::Bitsliced: return Kernels().decipher;
+    default:                return DecipherBulkScalar<Rounds, Xtea, Order>;
+    }
+}
+
+} // namespace Detail
+
+/**
+ * @brief SetKernel
+ * @details Forces the kernel used by Encrypt and Decrypt, e.g. for benchmarking.
+ * The XTEA_KERNEL environment variable has the same effect at startup.
+ * Must not be called concurrently with Encrypt or Decrypt
+ * @param kernel Kernel to use or Kernel::Auto for the best supported one
+ * @return false if the running CPU does not support the kernel, which is then not changed
+ */
+inline bool SetKernel(Kernel kernel) noexcept {
+    if (kernel != Kernel::Auto && !Detail::IsSupported(kernel)) return false;
+    Detail::Kernels() = Detail::MakeKernelTable(Detail::ResolveKernel(kernel));
+    return true;
+}
+
+/**
+ * @brief ActiveKernel
+ * @return Kernel currently used by Encrypt and Decrypt
+ */
+inline Kernel ActiveKernel() noexcept {
+    return Detail::Kernels().kernel;
+}
+
+/**
+ * @brief Task
+ * @details Work of a parallel call handed to an Executor: Size() independent ranges
+ * of the data, range i being processed by task(i)
+ */
+class Task {
+public:
+    template<class Fn>
+    Task(size_t size, const Fn& fn) noexcept
+        : size_(size), fn_(&fn), call_([](const void* f, size_t i) { (*(const Fn*)f)(i); }) {}
+
+    /**
+     * @brief Size
+     * @return Number of ranges
+     */
+    size_t Size() const noexcept { return size_; }
+
+    /**
+     * @brief operator()
+     * @details Processes range i, for i in [0, Size())
+     */
+    void operator()(size_t i) const noexcept { call_(fn_, i); }
+
+private:
+    size_t size_;
+    const void* fn_;
+    void (*call_)(const void* fn, size_t i);
+};
+
+class Executor;
+
+namespace Detail {
+
+/**
+ * @brief ExecutorThreads
+ * @details fn.Threads() if fn has it, as the executors of this header do, 0 otherwise
+ */
+template<class Fn>
+inline auto ExecutorThreads(const Fn& fn, int) noexcept -> decltype((uint)fn.Threads()) {
+    return fn.Threads();
+}
+
+template<class Fn>
+inline uint ExecutorThreads(const Fn&, long) noexcept {
+    return 0;
+}
+
+template<class Fn>
+using IfTaskCallable = decltype(std::declval<const Fn&>()(std::declval<const Task&>()), void());
+
+template<class Fn>
+using IfNotExecutor = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type, Executor>::value>::type;
+
+} // namespace Detail
+
+/**
+ * @brief Executor
+ * @details Runs the ranges of parallel calls on threads of the caller's choosing,
+ * e.g. to share them with other work and not oversubscribe the CPU. Any callable
+ * taking a const Task& which calls task(i) exactly once for every i in [0, task.Size()),
+ * on any threads and in any order, and returns once all of them have returned.
+ * See PoolExecutor, ThreadExecutor, OpenMpExecutor and QtExecutor.
+ * The number of threads the ranges run on sizes them: it is taken from Threads()
+ * of the executors of this header and can be given for any other callable
+ */
+class Executor {
+public:
+    Executor() noexcept : threads(0) {}
+    Executor(std::nullptr_t) noexcept : threads(0) {}
+
+    /**
+     * @param fn Callable taking a const Task&
+     */
+    template<class Fn, class = Detail::IfTaskCallable<Fn>, class = Detail::IfNotExecutor<Fn> >
+    Executor(Fn fn) : threads(Detail::ExecutorThreads(fn, 0)), fn_(std::move(fn)) {}
+
+    /**
+     * @param fn Callable taking a const Task&
+     * @param n_threads Number of threads fn runs the ranges on, 0 if not known
+     */
+    template<class Fn, class = Detail::IfTaskCallable<Fn> >
+    Executor(Fn fn, uint n_threads) : threads(n_threads), fn_(std::move(fn)) {}
+
+    explicit operator bool() const noexcept { return (bool)fn_; }
+
+    void operator()(const Task& task) const { fn_(task); }
+
+    uint threads; ///< Number of threads the ranges run on, 0 if not known, in which case it is taken as the hardware concurrency
+
+private:
+    std::function<void(const Task& task)> fn_;
+};
+
+namespace Detail {
+
+/**
+ * @brief STACK_ROUNDS
+ * @details Encrypt and Decrypt with a raw key expand up to this many rounds
+ * on the stack; more rounds go through a heap-allocated Context
+ */
+constexpr const uint STACK_ROUNDS = 64;
+
+/**
+ * @brief EncipherData
+ * @details Runs the bulk kernel over the whole blocks of src and the scalar rounds over
+ * what it leaves, writing to dst, which may be src. A partial last block is left as is
+ */
+template<uint Rounds = 0>
+inline void EncipherData(const uchar* src, uchar* dst, size_t size, const Schedule& s, BulkFn bulk) noexcept {
+    const size_t n_blocks = size / BLOCK_SIZE;
+    size_t i = bulk(src, dst, n_blocks, s);
+    for(; i < n_blocks; i++) {
+        uint32_t v[2];
+        LoadBlock(v, src + (BLOCK_SIZE * i), s.order);
+        if (s.algorithm == Algorithm::Tea) LaneRounds<Tea, Rounds>::template Encipher<1>(&v[0], &v[1], s);
+        else LaneRounds<Xtea, Rounds>::template Encipher<1>(&v[0], &v[1], s);
+        StoreBlock(dst + (BLOCK_SIZE * i), v, s.order);
+    }
+}
+
+/**
+ * @brief DecipherData
+ * @details Counterpart of EncipherData
+ */
+template<uint Rounds = 0>
+inline void DecipherData(const uchar* src, uchar* dst, size_t size, const Schedule& s, BulkFn bulk) noexcept {
+    const size_t n_blocks = size / BLOCK_SIZE;
+    size_t i = bulk(src, dst, n_blocks, s);
+    for(; i < n_blocks; i++) {
+        uint32_t v[2];
+        LoadBlock(v, src + (BLOCK_SIZE * i), s.order);
+        if (s.algorithm == Algorithm::Tea) LaneRounds<Tea, Rounds>::template Decipher<1>(&v[0], &v[1], s);
+        else LaneRounds<Xtea, Rounds>::template Decipher<1>(&v[0], &v[1], s);
+        StoreBlock(dst + (BLOCK_SIZE * i), v, s.order);
+    }
+}
+
+/**
+ * @brief PARALLEL_GRAIN
+ * @details Smallest number of blocks worth handing to a separate thread.
+ * Smaller buffers are encrypted on the calling thread alone
+ */
+constexpr const size_t PARALLEL_GRAIN = 16384;
+
+/**
+ * @brief PARALLEL_CHUNK
+ * @details Largest number of blocks a thread takes at a time, 256 KiB, so a range stays
+ * in L2 and threads that finish early take over the ranges of slower ones
+ */
+constexpr const size_t PARALLEL_CHUNK = 32768;
+
+/**
+ * @brief TaskQueue
+ * @details Hands out the ranges of a task to the threads calling Work, one at a time
+ */
+struct TaskQueue {
+    const Task& task;
+    std::atomic<size_t> next;
+
+    explicit TaskQueue(const Task& queued) noexcept : task(queued), next(0) {}
+
+    void Work() noexcept {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < task.Size();) task(i);
+    }
+};
+
+/**
+ * @brief Placement
+ * @details Memory a task works on, range i starting at data + stride * i, so that
+ * the ThreadPool can run each range on the NUMA node holding it
+ */
+struct Placement {
+    const void* data;
+    size_t stride;
+
+    Placement(const void* memory = nullptr, size_t range_stride = 0) noexcept : data(memory), stride(range_stride) {}
+};
+
+/**
+ * @brief NodeQueues
+ * @details Hands out the ranges of a task grouped by NUMA node. A thread takes the
+ * ranges of its own node first, then helps with those of the other nodes
+ */
+struct NodeQueues {
+    const Task& task;
+    std::vector<size_t> ranges;             ///< Ranges of node k are ranges[first[k]] to ranges[first[k + 1] - 1]
+    std::vector<size_t> first;
+    std::vector<std::atomic<size_t>> next;
+
+    /**
+     * @param nodes Node of each range of the task, in [0, n_nodes)
+     */
+    NodeQueues(const Task& queued, const std::vector<uint>& nodes, uint n_nodes)
+        : task(queued), ranges(queued.Size()), first(n_nodes + 1, 0), next(n_nodes) {
+        for (size_t i = 0; i < task.Size(); i++) first[nodes[i] + 1]++;
+        for (uint k = 0; k < n_nodes; k++) first[k + 1] += first[k];
+        std::vector<size_t> fill(first.begin(), first.end() - 1);
+        for (size_t i = 0; i < task.Size(); i++) ranges[fill[nodes[i]]++] = i;
+    }
+
+    void Work(uint node) noexcept {
+        const uint n_nodes = (uint)next.size();
+        for (uint j = 0; j < n_nodes; j++) {
+            const uint k = (node + j) % n_nodes;
+            const size_t n = first[k + 1] - first[k];
+            for (size_t i; (i = next[k].fetch_add(1, std::memory_order_relaxed)) < n;) task(ranges[first[k] + i]);
+        }
+    }
+};
+
+#ifdef XTEA_HAS_NUMA
+
+/**
+ * @brief ReadList
+ * @details Appends the numbers of a sysfs list such as "0-3,8-11" to list,
+ * false if the file can't be read
+ */
+inline bool ReadList(const char* path, std::vector<int>& list) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    char line[4096];
+    const bool read = fgets(line, sizeof(line), file) != nullptr;
+    fclose(file);
+    if (!read) return false;
+    for (char* p = line; *p >= '0' && *p <= '9';) {
+        const long first = strtol(p, &p, 10);
+        long last = first;
+        if (*p == '-') last = strtol(p + 1, &p, 10);
+        for (long i = first; i <= last; i++) list.push_back((int)i);
+        if (*p == ',') p++;
+    }
+    return true;
+}
+
+/**
+ * @brief NumaNode
+ * @details A NUMA node and those of its CPUs the process may run on
+ */
+struct NumaNode {
+    int id;
+    cpu_set_t cpus;
+    uint n_cpus;
+};
+
+/**
+ * @brief NumaNodes
+ * @details The NUMA nodes with CPUs the process may run on. Empty when there is only
+ * one such node or the topology is not available
+ */
+inline std::vector<NumaNode> NumaNodes() {
+    std::vector<NumaNode> nodes;
+    cpu_set_t allowed;
+    std::vector<int> online;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 ||
+        !ReadList("/sys/devices/system/node/online", online)) return nodes;
+    for (int id : online) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+        std::vector<int> cpus;
+        if (!ReadList(path, cpus)) continue;
+        NumaNode node;
+        node.id = id;
+        node.n_cpus = 0;
+        CPU_ZERO(&node.cpus);
+        for (int cpu : cpus) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)) continue;
+            CPU_SET(cpu, &node.cpus);
+            node.n_cpus++;
+        }
+        if (node.n_cpus != 0) nodes.push_back(node);
+    }
+    if (nodes.size() < 2) nodes.clear();
+    return nodes;
+}
+
+/**
+ * @brief PageNodes
+ * @details Queries the NUMA node of the page at data + stride * i for each i in [0, n),
+ * with move_pages and no target nodes, which moves nothing. -1 for pages not
+ * yet faulted in, and for all of them when the call is not permitted
+ */
+inline std::vector<int> PageNodes(const void* data, size_t stride, size_t n) {
+    std::vector<int> status(n, -1);
+#ifdef SYS_move_pages
+    const uintptr_t page_mask = ~(uintptr_t)(sysconf(_SC_PAGESIZE) - 1);
+    std::vector<void*> pages(n);
+    for (size_t i = 0; i < n; i++) pages[i] = (void*)(((uintptr_t)data + stride * i) & page_mask);
+    if (syscall(SYS_move_pages, 0, (unsigned long)n, pages.data(), nullptr, status.data(), 0) != 0) {
+        status.assign(n, -1);
+    }
+#else
+    (void)data;
+    (void)stride;
+#endif
+    return status;
+}
+
+#endif /* ifdef(XTEA_HAS_NUMA) */
+
+/**
+ * @brief ThreadPool
+ * @details Worker threads started on first use, one less than the hardware concurrency,
+ * which sleep between calls. The calling thread works along with them. One call
+ * uses the pool at a time: a call made while it is busy, e.g. from another thread
+ * or from within a task, runs all of its tasks on the calling thread.
+ * On a NUMA machine the workers form one group per node, each bound to the CPUs of
+ * its node, and a call on all threads with a Placement runs the ranges on the node
+ * holding their first page; see Run
+ */
+class ThreadPool {
+public:
+    static ThreadPool& Instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& worker : workers_) worker.join();
+    }
+
+    /**
+     * @brief Run
+     * @details Runs the task on up to n_threads threads, the calling one included,
+     * and returns once all of its ranges are done. On a NUMA machine, when all threads
+     * are used and the placement is given, each thread first takes the ranges whose first
+     * page is on its node, then helps with the others. Ranges not yet faulted in, whose
+     * node first touch decides, are shared evenly across the nodes
+     * @param n_threads Number of threads, 0 for all of them
+     * @param placement Memory of the ranges, if known
+     */
+    void Run(const Task& task, uint n_threads, const Placement& placement = Placement()) {
+        std::unique_lock<std::mutex> submit(submit_, std::try_to_lock);
+        if (!submit.owns_lock() || n_threads == 1 || task.Size() <= 1 || workers_.empty()) {
+            for (size_t i = 0; i < task.Size(); i++) task(i);
+            return;
+        }
+        Job job(task);
+        job.max_helpers = n_threads == 0 || n_threads > workers_.size() ? (uint)workers_.size() : n_threads - 1;
+        uint node = 0;
+#ifdef XTEA_HAS_NUMA
+        std::unique_ptr<NodeQueues> nodes;
+        if (!nodes_.empty() && placement.data && job.max_helpers == workers_.size()) {
+            nodes.reset(new NodeQueues(task, RangeNodes(placement, task.Size()), (uint)nodes_.size()));
+            job.nodes = nodes.get();
+            node = CurrentNode();
+        }
+#else
+        (void)placement;
+#endif
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            generation_++;
+        }
+        wake_.notify_all();
+        job.Work(node);
+        // The job lives on this stack, so wait for the workers still running its tasks
+        std::unique_lock<std::mutex> lock(mutex_);
+        job_ = nullptr;
+        done_.wait(lock, [&] { return job.active == 0; });
+    }
+
+private:
+    struct Job {
+        TaskQueue queue;
+        NodeQueues* nodes = nullptr; ///< Ranges by NUMA node, or all of them in queue
+        uint max_helpers;
+        uint helpers = 0; ///< Workers which joined, guarded by mutex_
+        uint active = 0;  ///< Workers still running ranges, guarded by mutex_
+
+        explicit Job(const Task& task) noexcept : queue(task) {}
+
+        void Work(uint node) noexcept {
+            if (nodes) nodes->Work(node);
+            else queue.Work();
+        }
+    };
+
+    ThreadPool() {
+#ifdef XTEA_HAS_NUMA
+        nodes_ = NumaNodes();
+        if (!nodes_.empty()) {
+            for (size_t k = 0; k < nodes_.size(); k++) {
+                const int id = nodes_[k].id;
+                if ((size_t)id >= node_groups_.size()) node_groups_.resize(id + 1, -1);
+                node_groups_[id] = (int)k;
+            }
+            // One worker per CPU of each node, less the calling thread
+            const uint caller = CurrentNode();
+            for (uint k = 0; k < (uint)nodes_.size(); k++) {
+                for (uint i = k == caller ? 1 : 0; i < nodes_[k].n_cpus; i++) {
+                    if (!Start(k)) return;
+                }
+            }
+            return;
+        }
+#endif
+        const uint n = std::thread::hardware_concurrency();
+        for (uint i = 1; i < n; i++) {
+            if (!Start(0)) break;
+        }
+    }
+
+    bool Start(uint node) {
+        try {
+            workers_.emplace_back([this, node] { Loop(node); });
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+#ifdef XTEA_HAS_NUMA
+    /**
+     * @brief CurrentNode
+     * @details Group of the node the calling thread runs on, 0 if unknown
+     */
+    uint CurrentNode() const noexcept {
+        const int cpu = sched_getcpu();
+        for (size_t k = 0; cpu >= 0 && cpu < CPU_SETSIZE && k < nodes_.size(); k++) {
+            if (CPU_ISSET(cpu, &nodes_[k].cpus)) return (uint)k;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief RangeNodes
+     * @details Group of the node holding the first page of each of the n ranges
+     */
+    std::vector<uint> RangeNodes(const Placement& placement, size_t n) const {
+        const std::vector<int> pages = PageNodes(placement.data, placement.stride, n);
+        const size_t n_nodes = nodes_.size();
+        std::vector<uint> nodes(n);
+        for (size_t i = 0; i < n; i++) {
+            const int id = pages[i];
+            const int group = id >= 0 && (size_t)id < node_groups_.size() ? node_groups_[id] : -1;
+            nodes[i] = group >= 0 ? (uint)group : (uint)(i * n_nodes / n);
+        }
+        return nodes;
+    }
+#endif
+
+    void Loop(uint node) {
+#ifdef XTEA_HAS_NUMA
+        if (!nodes_.empty()) sched_setaffinity(0, sizeof(cpu_set_t), &nodes_[node].cpus);
+#endif
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return stop_ || (job_ && generation_ != seen); });
+            if (stop_) return;
+            seen = generation_;
+            Job* job = job_;
+            if (job->helpers == job->max_helpers) continue;
+            job->helpers++;
+            job->active++;
+            lock.unlock();
+            job->Work(node);
+            lock.lock();
+            if (--job->active == 0) done_.notify_one();
+        }
+    }
+
+#ifdef XTEA_HAS_NUMA
+    std::vector<NumaNode> nodes_;    ///< Empty unless there are several nodes
+    std::vector<int> node_groups_;   ///< Index in nodes_ of each node number, -1 for nodes without CPUs
+#endif
+    std::vector<std::thread> workers_;
+    std::mutex submit_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    Job* job_ = nullptr;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+/**
+ * @brief ParallelChunk
+ * @details Size of the ranges [0, n) is split into for up to n_threads threads:
+ * an even share of each thread but at most PARALLEL_CHUNK and at least grain items.
+ * n itself when the range is too small to be split
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline size_t ParallelChunk(size_t n, size_t grain, uint n_threads) noexcept {
+    if (n_threads == 0) n_threads = std::thread::hardware_concurrency();
+    size_t max_threads = n / (grain ? grain : 1);
+    if (n_threads > max_threads) n_threads = (uint)max_threads;
+    if (n_threads <= 1) return n;
+    const size_t chunk = (n + n_threads - 1) / n_threads;
+    const size_t max_chunk = PARALLEL_CHUNK > grain ? PARALLEL_CHUNK : grain;
+    return chunk < max_chunk ? chunk : max_chunk;
+}
+
+/**
+ * @brief ParallelChunk
+ * @details For an executor, with the number of threads it declares
+ */
+inline size_t ParallelChunk(size_t n, size_t grain, const Executor& executor) noexcept {
+    return ParallelChunk(n, grain, executor.threads);
+}
+
+inline void RunTask(const Task& task, uint n_threads, const Placement& placement = Placement()) {
+    ThreadPool::Instance().Run(task, n_threads, placement);
+}
+
+inline void RunTask(const Task& task, const Executor& executor, const Placement& = Placement()) {
+    if (!executor) {
+        for (size_t i = 0; i < task.Size(); i++) task(i);
+        return;
+    }
+    executor(task);
+}
+
+/**
+ * @brief ParallelFor
+ * @details Calls fn(begin, end) for the consecutive ranges of chunk items covering
+ * [0, n), on the calling thread and up to n_threads - 1 workers of the ThreadPool,
+ * or on an Executor. fn must not throw
+ * @param threads Number of threads, 0 for all of them, or an Executor
+ * @param data Memory of the blocks, item i at data + BLOCK_SIZE * i, if any,
+ * so that the ThreadPool runs each range on its NUMA node
+ */
+template<class Threads, class Fn>
+inline void ParallelFor(size_t n, size_t chunk, const Threads& threads, const Fn& fn, const void* data = nullptr) {
+    if (chunk >= n) {
+        fn((size_t)0, n);
+        return;
+    }
+    const auto range = [&](size_t i) {
+        const size_t begin = chunk * i;
+        fn(begin, n - begin > chunk ? begin + chunk : n);
+    };
+    RunTask(Task((n + chunk - 1) / chunk, range), threads, Placement(data, BLOCK_SIZE * chunk));
+}
+
+/**
+ * @brief ParallelBytes
+ * @details ParallelFor over the blocks of size bytes at data, the last one possibly partial.
+ * Calls fn(offset, length) with byte offsets and lengths
+ */
+template<class Threads, class Fn>
+inline void ParallelBytes(const void* data, size_t size, const Threads& threads, const Fn& fn) {
+    const size_t n_blocks = size / BLOCK_SIZE + (size % BLOCK_SIZE != 0);
+    const size_t chunk = ParallelChunk(n_blocks, PARALLEL_GRAIN, threads);
+    ParallelFor(n_blocks, chunk, threads, [&](size_t begin, size_t end) {
+        const size_t offset = BLOCK_SIZE * begin;
+        fn(offset, end == n_blocks ? size - offset : BLOCK_SIZE * (end - begin));
+    }, data);
+}
+
+/**
+ * @brief CtrKeystream
+ * @details Enciphers one counter block
+ */
+inline void CtrKeystream(uint32_t ks[2], uint64_t counter, const Schedule& s) noexcept {
+    ks[0] = (uint32_t)counter;
+    ks[1] = (uint32_t)(counter >> 32);
+    EncipherLanes<1>(&ks[0], &ks[1], s);
+}
+
+/**
+ * @brief CtrXor
+ * @details XORs n (at most BLOCK_SIZE - skip) bytes of the keystream block
+ * for counter, starting at byte skip of that block, into data
+ */
+inline void CtrXor(uchar* data, size_t n, size_t skip, uint64_t counter, const Schedule& s) noexcept {
+    uint32_t ks[2];
+    uchar k[BLOCK_SIZE];
+    CtrKeystream(ks, counter, s);
+    StoreBlock(k, ks, s.order);
+    for (size_t i = 0; i < n; i++) data[i] ^= k[skip + i];
+}
+
+/**
+ * @brief CtrData
+ * @details Counter mode over whole blocks: the kernel first, then the scalar rounds
+ */
+inline void CtrData(uchar* data, size_t n_blocks, const Schedule& s, uint64_t counter, CtrFn bulk) noexcept {
+    size_t i = bulk(data, n_blocks, s, counter);
+    for (; i < n_blocks; i++) {
+        CtrXor(data + BLOCK_SIZE * i, BLOCK_SIZE, 0, counter + i, s);
+    }
+}
+
+/**
+ * @brief CBC_BATCH
+ * @details Blocks of ciphertext DecipherCbc keeps a copy of on the stack at a time
+ */
+constexpr const size_t CBC_BATCH = 256;
+
+/**
+ * @brief EncipherCbc
+ * @details Serial by nature: each block is chained to the previous ciphertext block
+ */
+inline void EncipherCbc(uchar* data, size_t n_blocks, const Schedule& s, const uchar iv[BLOCK_SIZE]) noexcept {
+    const uchar* prev = iv;
+    for (size_t i = 0; i < n_blocks; i++) {
+        uchar* p = data + BLOCK_SIZE * i;
+        for (size_t j = 0; j < BLOCK_SIZE; j++) p[j] ^= prev[j];
+        EncipherBytes(p, p, s);
+        prev = p;
+    }
+}
+
+/**
+ * @brief DecipherCbc
+ * @details Deciphers batches of blocks with the bulk kernel, then XORs each block
+ * with the ciphertext block before it, taken from a copy of the batch
+ * @param prev_block Ciphertext block preceding data, or the IV
+ */
+inline void DecipherCbc(uchar* data, size_t n_blocks, const Schedule& s, const uchar prev_block[BLOCK_SIZE], BulkFn bulk) noexcept {
+    uchar cipher[BLOCK_SIZE + BLOCK_SIZE * CBC_BATCH];
+    memcpy(cipher, prev_block, BLOCK_SIZE);
+    for (size_t i = 0; i < n_blocks; i += CBC_BATCH) {
+        size_t n = n_blocks - i < CBC_BATCH ? n_blocks - i : CBC_BATCH;
+        uchar* p = data + BLOCK_SIZE * i;
+        memcpy(cipher + BLOCK_SIZE, p, BLOCK_SIZE * n);
+        DecipherData(p, p, BLOCK_SIZE * n, s, bulk);
+        for (size_t j = 0; j < BLOCK_SIZE * n; j++) p[j] ^= cipher[j];
+        memcpy(cipher, cipher + BLOCK_SIZE * n, BLOCK_SIZE);
+    }
+}
+
+} // namespace Detail
+
+/**
+ * @brief PoolExecutor
+ * @details Executor on the thread pool of this header, the one the overloads
+ * taking a number of threads use
+ */
+class PoolExecutor {
+public:
+    /**
+     * @param n_threads Number of threads, 0 for the hardware concurrency
+     */
+    explicit PoolExecutor(uint n_threads = 0) noexcept : n_threads_(n_threads) {}
+
+    void operator()(const Task& task) const {
+        Detail::ThreadPool::Instance().Run(task, n_threads_);
+    }
+
+    uint Threads() const noexcept { return n_threads_; }
+
+private:
+    uint n_threads_;
+};
+
+/**
+ * @brief ThreadExecutor
+ * @details Executor starting threads for each call, which the calling thread
+ * works along with and joins before returning
+ */
+class ThreadExecutor {
+public:
+    /**
+     * @param n_threads Number of threads, the calling one included, 0 for the hardware concurrency
+     */
+    explicit ThreadExecutor(uint n_threads = 0) noexcept : n_threads_(n_threads) {}
+
+    void operator()(const Task& task) const {
+        Detail::TaskQueue queue(task);
+        size_t n_threads = n_threads_ ? n_threads_ : std::thread::hardware_concurrency();
+        if (n_threads > task.Size()) n_threads = task.Size();
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < n_threads; i++) {
+            try {
+                workers.emplace_back([&queue] { queue.Work(); });
+            } catch (...) {
+                break;
+            }
+        }
+        queue.Work();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    uint Threads() const noexcept { return n_threads_; }
+
+private:
+    uint n_threads_;
+};
+
+#ifdef _OPENMP
+/**
+ * @brief OpenMpExecutor
+ * @details Executor on the OpenMP thread team, with dynamic scheduling of the ranges
+ */
+class OpenMpExecutor {
+public:
+    void operator()(const Task& task) const {
+        const ptrdiff_t n = (ptrdiff_t)task.Size();
+#pragma omp parallel for schedule(dynamic)
+        for (ptrdiff_t i = 0; i < n; i++) task((size_t)i);
+    }
+
+    uint Threads() const noexcept { return (uint)omp_get_max_threads(); }
+};
+#endif /* ifdef(_OPENMP) */
+
+#ifdef QT_CORE_LIB
+/**
+ * @brief QtExecutor
+ * @details Executor on a QThreadPool. Only threads of the pool which are idle join a
+ * call, through QThreadPool::tryStart, and the calling thread works along with them,
+ * so a call never waits behind other work queued on the pool
+ */
+class QtExecutor {
+public:
+    /**
+     * @param pool Pool to run on, which must outlive the calls
+     */
+    explicit QtExecutor(QThreadPool* pool = QThreadPool::globalInstance()) noexcept : pool_(pool) {}
+
+    void operator()(const Task& task) const {
+        Detail::TaskQueue queue(task);
+        QSemaphore done;
+        size_t max_helpers = task.Size() > 0 ? task.Size() - 1 : 0;
+        if (max_helpers > (size_t)pool_->maxThreadCount()) max_helpers = (size_t)pool_->maxThreadCount();
+        int n_helpers = 0;
+        for (; (size_t)n_helpers < max_helpers; n_helpers++) {
+            Runnable* runnable = new Runnable(queue, done);
+            if (!pool_->tryStart(runnable)) {
+                delete runnable;
+                break;
+            }
+        }
+        queue.Work();
+        done.acquire(n_helpers);
+    }
+
+    uint Threads() const noexcept { return (uint)pool_->maxThreadCount() + 1; }
+
+private:
+    class Runnable : public QRunnable {
+    public:
+        Runnable(Detail::TaskQueue& queue, QSemaphore& done) noexcept : queue_(queue), done_(done) {}
+
+        void run() override {
+            queue_.Work();
+            done_.release();
+        }
+
+    private:
+        Detail::TaskQueue& queue_;
+        QSemaphore& done_;
+    };
+
+    QThreadPool* pool_;
+};
+#endif /* ifdef(QT_CORE_LIB) */
+
+#ifdef XTEA_HAS_EXECUTION
+/**
+ * @brief PolicyExecutor
+ * @details Executor on the standard parallel algorithms: the ranges are the elements
+ * of a std::for_each under a standard execution policy, e.g. std::execution::par_unseq,
+ * so they run on the backend of the standard library (TBB for libstdc++).
+ * Ranges call the kernels only, which is allowed under the unsequenced policies
+ */
+template<class ExecutionPolicy>
+class PolicyExecutor {
+public:
+    explicit PolicyExecutor(const ExecutionPolicy& policy) : policy_(policy) {}
+
+    void operator()(const Task& task) const {
+        std::vector<size_t> ranges(task.Size());
+        std::iota(ranges.begin(), ranges.end(), (size_t)0);
+        std::for_each(policy_, ranges.begin(), ranges.end(), [&task](size_t i) { task(i); });
+    }
+
+private:
+    ExecutionPolicy policy_;
+};
+
+namespace Detail {
+
+template<class ExecutionPolicy>
+using IfExecutionPolicy = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>;
+
+} // namespace Detail
+#endif /* ifdef(XTEA_HAS_EXECUTION) */
+
+/**
+ * @brief Message
+ * @details One entry of a batch for EncryptBatch and DecryptBatch
+ */
+struct Message {
+    uchar* data;      ///< Encrypted or decrypted in place
+    size_t size;      ///< In bytes, multiple of XTEA_BLOCK_SIZE; a partial last block is left as is
+    const uchar* key; ///< Any 128-bit block
+};
+
+namespace Detail {
+
+/**
+ * @brief MultiData
+ * @details Packs the whole blocks of all messages, each with the key of its message,
+ * into the lanes of the multi-key kernel and writes them back after every pass
+ */
+inline void MultiData(const Message* messages, size_t n_messages, uint n_rounds, Algorithm algorithm, MultiFn multi) noexcept {
+    uint32_t v0[MULTI_LANES], v1[MULTI_LANES], key[4 * MULTI_LANES];
+    uchar* out[MULTI_LANES];
+    uint lanes = 0;
+    for (size_t m = 0; m < n_messages; m++) {
+        const size_t n_blocks = messages[m].size / BLOCK_SIZE;
+        for (size_t i = 0; i < n_blocks; i++) {
+            uchar* p = messages[m].data + BLOCK_SIZE * i;
+            v0[lanes] = LoadWord(p);
+            v1[lanes] = LoadWord(p + 4);
+            for (uint w = 0; w < 4; w++) key[MULTI_LANES * w + lanes] = LoadWord(messages[m].key + 4 * w);
+            out[lanes++] = p;
+            if (lanes < MULTI_LANES) continue;
+            multi(v0, v1, key, n_rounds, algorithm);
+            for (uint l = 0; l < MULTI_LANES; l++) {
+                StoreWord(out[l], v0[l]);
+                StoreWord(out[l] + 4, v1[l]);
+            }
+            lanes = 0;
+        }
+    }
+    if (lanes == 0) return;
+    // Lanes past the last block still hold earlier blocks, enciphered and dropped
+    multi(v0, v1, key, n_rounds, algorithm);
+    for (uint l = 0; l < lanes; l++) {
+        StoreWord(out[l], v0[l]);
+        StoreWord(out[l] + 4, v1[l]);
+    }
+}
+
+/**
+ * @brief WholeBlocks
+ * @details size rounded down to whole blocks, the part of a buffer EncipherData
+ * and DecipherData process
+ */
+constexpr size_t WholeBlocks(size_t size) noexcept {
+    return size - size % BLOCK_SIZE;
+}
+
+} // namespace Detail
+
+/**
+ * @brief Encrypt
+ * @param data Pointer to the data that will be encrypted. No additional data will be created
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE:
+ * a partial last block is left as is, see the variants with a Tail for other sizes
+ * @param ctx Expanded key
+ */
+inline void Encrypt(uchar* data, size_t size, const Context& ctx) noexcept {
+    Detail::EncipherData(data, data, size, ctx.EncipherSchedule(), Detail::Kernels().encipher);
+}
+
+/**
+ * @brief Encrypt
+ * @details Out-of-place variant: the kernels read plaintext from src and write
+ * ciphertext to dst in a single pass, leaving src untouched
+ * @param src Pointer to the data that will be encrypted
+ * @param dst Pointer to where the encrypted data is written. Either src itself
+ * or a buffer of the same size that does not overlap it
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE:
+ * only whole blocks are processed, the bytes past the last one are neither read nor written
+ * @param ctx Expanded key
+ */
+inline void Encrypt(const void* src, void* dst, size_t size, const Context& ctx) noexcept {
+    Detail::EncipherData((const uchar*)src, (uchar*)dst, Detail::WholeBlocks(size), ctx.EncipherSchedule(), Detail::Kernels().encipher);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Pointer to the data that will be decrypted
+ * @param size Size of data provided in bytes. Must be multiple of XTEA_BLOCK_SIZE:
+ * a partial last block is left as is, see the variants with a Tail for other sizes
+ * @param ctx Expanded key which was used to encrypt
+ */
+inline void Decrypt(uchar* data, size_t size, const Context& ctx) noexcept {
+    Detail::DecipherData(data, data, size, ctx.DecipherSchedule(), Detail::Kernels().decipher);
+}
+
+/**
+ * @brief Decrypt
+ * @details Out-of-place variant, see Encrypt
+ * @param src Pointer to the data that will be decrypted
+ * @param dst Pointer to where the decrypted data is written, src or a separate buffer
+ * @param size Size of data provided in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ */
+inline void Decrypt(const void* src, void* dst, size_t size, const Context& ctx) noexcept {
+    Detail::DecipherData((const uchar*)src, (uchar*)dst, Detail::WholeBlocks(size), ctx.DecipherSchedule(), Detail::Kernels().decipher);
+}
+
+namespace Detail {
+
+template<class Threads>
+inline void EncipherParallel(const void* src, void* dst, size_t size, const Context& ctx, const Threads& threads) {
+    size = WholeBlocks(size);
+    const Schedule s = ctx.EncipherSchedule();
+    const BulkFn bulk = Kernels().encipher;
+    ParallelBytes(src, size, threads, [&](size_t offset, size_t length) {
+        EncipherData((const uchar*)src + offset, (uchar*)dst + offset, length, s, bulk);
+    });
+}
+
+template<class Threads>
+inline void DecipherParallel(const void* src, void* dst, size_t size, const Context& ctx, const Threads& threads) {
+    size = WholeBlocks(size);
+    const Schedule s = ctx.DecipherSchedule();
+    const BulkFn bulk = Kernels().decipher;
+    ParallelBytes(src, size, threads, [&](size_t offset, size_t length) {
+        DecipherData((const uchar*)src + offset, (uchar*)dst + offset, length, s, bulk);
+    });
+}
+
+} // namespace Detail
+
+/**
+ * @brief Encrypt
+ * @details Multithreaded variant: large buffers are split into cache-sized ranges,
+ * encrypted with the active kernel by the calling thread and the workers of a pool
+ * kept across calls. Buffers under 2 * PARALLEL_GRAIN blocks (256 KiB) are encrypted
+ * on the calling thread alone, so it is cheap to call on buffers of any size
+ * @param src Pointer to the data that will be encrypted
+ * @param dst Pointer to where the encrypted data is written, src or a separate buffer
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void Encrypt(const void* src, void* dst, size_t size, const Context& ctx, uint n_threads) {
+    Detail::EncipherParallel(src, dst, size, ctx, n_threads);
+}
+
+/**
+ * @brief Encrypt
+ * @details Multithreaded variant on threads of the caller: the ranges are run by the executor
+ * @param src Pointer to the data that will be encrypted
+ * @param dst Pointer to where the encrypted data is written, src or a separate buffer
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param executor Runs the ranges, see Executor
+ */
+inline void Encrypt(const void* src, void* dst, size_t size, const Context& ctx, const Executor& executor) {
+    Detail::EncipherParallel(src, dst, size, ctx, executor);
+}
+
+/**
+ * @brief Decrypt
+ * @details Multithreaded variant, see Encrypt
+ * @param src Pointer to the data that will be decrypted
+ * @param dst Pointer to where the decrypted data is written, src or a separate buffer
+ * @param size Size of data provided in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void Decrypt(const void* src, void* dst, size_t size, const Context& ctx, uint n_threads) {
+    Detail::DecipherParallel(src, dst, size, ctx, n_threads);
+}
+
+/**
+ * @brief Decrypt
+ * @details Multithreaded variant on threads of the caller, see Encrypt
+ * @param src Pointer to the data that will be decrypted
+ * @param dst Pointer to where the decrypted data is written, src or a separate buffer
+ * @param size Size of data provided in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param executor Runs the ranges, see Executor
+ */
+inline void Decrypt(const void* src, void* dst, size_t size, const Context& ctx, const Executor& executor) {
+    Detail::DecipherParallel(src, dst, size, ctx, executor);
+}
+
+namespace Detail {
+
+/**
+ * @brief REENCRYPT_BATCH
+ * @details Blocks Reencrypt deciphers and enciphers again at a time, so that
+ * they are still in L1 for the second step
+ */
+constexpr const size_t REENCRYPT_BATCH = 512;
+
+template<class Threads>
+inline void ReencryptParallel(const void* src, void* dst, size_t size, const Context& from, const Context& to, const Threads& threads) {
+    size = WholeBlocks(size);
+    const Schedule d = from.DecipherSchedule();
+    const Schedule e = to.EncipherSchedule();
+    const BulkFn decipher = Kernels().decipher;
+    const BulkFn encipher = Kernels().encipher;
+    ParallelBytes(src, size, threads, [&](size_t offset, size_t length) {
+        for (size_t i = 0; i < length; i += BLOCK_SIZE * REENCRYPT_BATCH) {
+            const size_t n = length - i < BLOCK_SIZE * REENCRYPT_BATCH ? length - i : BLOCK_SIZE * REENCRYPT_BATCH;
+            uchar* out = (uchar*)dst + offset + i;
+            DecipherData((const uchar*)src + offset + i, out, n, d, decipher);
+            EncipherData(out, out, n, e, encipher);
+        }
+    });
+}
+
+} // namespace Detail
+
+/**
+ * @brief Reencrypt
+ * @details Decrypts with one context and encrypts the result with another in a single
+ * pass over the data, e.g. to migrate TEA ciphertext to XTEA or to change the key.
+ * The contexts may differ in algorithm, rounds and byte order
+ * @param src Pointer to the data encrypted with from
+ * @param dst Pointer to where the data encrypted with to is written, src or a separate buffer
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param from Expanded key which was used to encrypt
+ * @param to Expanded key to encrypt with
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void Reencrypt(const void* src, void* dst, size_t size, const Context& from, const Context& to, uint n_threads = 1) {
+    Detail::ReencryptParallel(src, dst, size, from, to, n_threads);
+}
+
+/**
+ * @brief Reencrypt
+ * @details Variant on threads of the caller, see Reencrypt
+ * @param src Pointer to the data encrypted with from
+ * @param dst Pointer to where the data encrypted with to is written, src or a separate buffer
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param from Expanded key which was used to encrypt
+ * @param to Expanded key to encrypt with
+ * @param executor Runs the ranges, see Executor
+ */
+inline void Reencrypt(const void* src, void* dst, size_t size, const Context& from, const Context& to, const Executor& executor) {
+    Detail::ReencryptParallel(src, dst, size, from, to, executor);
+}
+
+/**
+ * @brief Tail
+ * @details How Encrypt and Decrypt deal with a size that is not a multiple of
+ * XTEA_BLOCK_SIZE without touching memory past the end of the source.
+ * Tail::Pkcs7 always appends 1 to XTEA_BLOCK_SIZE bytes, each holding their count.
+ * Tail::Zero pads the last block with zeros into the spare space of the
+ * destination; the original size has to be known to the receiver.
+ * Tail::Stealing (ciphertext stealing) keeps the size as is, with at least one
+ * whole block, by enciphering the partial block together with the end of the
+ * previous ciphertext block; the last two ciphertext blocks are swapped
+ */
+enum class Tail {
+    Pkcs7,
+    Zero,
+    Stealing
+};
+
+/**
+ * @brief EncryptedSize
+ * @return Size of the ciphertext of size bytes with the given tail policy
+ */
+inline size_t EncryptedSize(size_t size, Tail tail) noexcept {
+    switch (tail) {
+    case Tail::Pkcs7: return (size / BLOCK_SIZE + 1) * BLOCK_SIZE;
+    case Tail::Zero:  return (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    default:          return size;
+    }
+}
+
+namespace Detail {
+
+/**
+ * @brief LoadPartialBlock
+ * @details Copies n (less than BLOCK_SIZE) bytes into block, filling the rest with pad
+ */
+inline void LoadPartialBlock(uchar block[BLOCK_SIZE], const uchar* p, size_t n, uchar pad) noexcept {
+    memset(block, pad, BLOCK_SIZE);
+    if (n != 0) memcpy(block, p, n);
+}
+
+} // namespace Detail
+
+/**
+ * @brief Encrypt
+ * @details Variant for any size. Only size bytes of src are read; the last
+ * block is assembled and enciphered on the stack
+ * @param src Pointer to the data that will be encrypted
+ * @param dst Pointer to where the EncryptedSize(size, tail) bytes of
+ * ciphertext are written, src or a separate buffer
+ * @param size Size of data provided, in bytes
+ * @param ctx Expanded key
+ * @param tail Padding policy
+ * @return false if size is too small for Tail::Stealing, in which case nothing is written
+ */
+inline bool Encrypt(const void* src, void* dst, size_t size, const Context& ctx, Tail tail) noexcept {
+    const uchar* in = (const uchar*)src;
+    uchar* out = (uchar*)dst;
+    const Detail::Schedule s = ctx.EncipherSchedule();
+    const size_t whole = size / BLOCK_SIZE * BLOCK_SIZE;
+    const size_t rest = size - whole;
+    if (tail == Tail::Stealing) {
+        if (size < BLOCK_SIZE) return false;
+        if (rest == 0) {
+            Detail::EncipherData(in, out, size, s, Detail::Kernels().encipher);
+            return true;
+        }
+        const size_t last = whole - BLOCK_SIZE;
+        Detail::EncipherData(in, out, last, s, Detail::Kernels().encipher);
+        uchar c[BLOCK_SIZE], v[BLOCK_SIZE];
+        Detail::EncipherBytes(c, in + last, s);
+        memcpy(v, c, BLOCK_SIZE);
+        memcpy(v, in + whole, rest);
+        Detail::EncipherBytes(out + last, v, s);
+        memcpy(out + whole, c, rest);
+        return true;
+    }
+    Detail::EncipherData(in, out, whole, s, Detail::Kernels().encipher);
+    if (tail == Tail::Zero && rest == 0) return true;
+    uchar v[BLOCK_SIZE];
+    Detail::LoadPartialBlock(v, in + whole, rest, tail == Tail::Pkcs7 ? (uchar)(BLOCK_SIZE - rest) : 0);
+    Detail::EncipherBytes(out + whole, v, s);
+    return true;
+}
+
+/**
+ * @brief Decrypt
+ * @details Counterpart of Encrypt with a tail policy
+ * @param src Pointer to the data that will be decrypted
+ * @param dst Pointer to where the decrypted data is written, src or a separate buffer
+ * @param size Size of the ciphertext, in bytes
+ * @param ctx Expanded key which was used to encrypt
+ * @param tail Padding policy which was used to encrypt
+ * @param plain_size Receives the size of the plaintext. With Tail::Zero it includes
+ * the padding, which the caller has to strip
+ * @return false if size is not valid for the policy or the PKCS#7 padding is malformed
+ */
+inline bool Decrypt(const void* src, void* dst, size_t size, const Context& ctx, Tail tail, size_t& plain_size) noexcept {
+    const uchar* in = (const uchar*)src;
+    uchar* out = (uchar*)dst;
+    const Detail::Schedule s = ctx.DecipherSchedule();
+    const size_t whole = size / BLOCK_SIZE * BLOCK_SIZE;
+    const size_t rest = size - whole;
+    if (tail == Tail::Stealing) {
+        if (size < BLOCK_SIZE) return false;
+        plain_size = size;
+        if (rest == 0) {
+            Detail::DecipherData(in, out, size, s, Detail::Kernels().decipher);
+            return true;
+        }
+        const size_t last = whole - BLOCK_SIZE;
+        Detail::DecipherData(in, out, last, s, Detail::Kernels().decipher);
+        uchar v[BLOCK_SIZE], c[BLOCK_SIZE];
+        Detail::DecipherBytes(v, in + last, s);
+        memcpy(c, v, BLOCK_SIZE);
+        memcpy(c, in + whole, rest);
+        Detail::DecipherBytes(out + last, c, s);
+        memcpy(out + whole, v, rest);
+        return true;
+    }
+    if (rest != 0 || (tail == Tail::Pkcs7 && size == 0)) return false;
+    Detail::DecipherData(in, out, size, s, Detail::Kernels().decipher);
+    plain_size = size;
+    if (tail == Tail::Zero) return true;
+    const uchar n = out[size - 1];
+    uchar bad = (uchar)(n == 0 || n > BLOCK_SIZE);
+    for (size_t i = 1; i <= BLOCK_SIZE; i++) {
+        // Checks every byte of the last block, so the time does not depend on n
+        bad |= (uchar)((i <= n) & (out[size - i] != n));
+    }
+    if (bad) return false;
+    plain_size = size - n;
+    return true;
+}
+
+namespace Detail {
+
+/**
+ * @brief EncipherKey
+ * @details EncipherData with a raw XTEA key, expanded on the stack up to STACK_ROUNDS
+ */
+inline void EncipherKey(const uchar* src, uchar* dst, size_t size, const uchar* key, uint n_rounds, ByteOrder order) noexcept {
+    if (n_rounds > STACK_ROUNDS) {
+        const Context ctx(key, n_rounds, order);
+        EncipherData(src, dst, size, ctx.EncipherSchedule(), Kernels().encipher);
+        return;
+    }
+    const Key k(key, order);
+    uint32_t round_keys[2 * STACK_ROUNDS];
+    ExpandKey(k.w, n_rounds, round_keys, false, DEFAULT_ALGORITHM);
+    EncipherData(src, dst, size, { k.w, round_keys, n_rounds, order, DEFAULT_ALGORITHM }, Kernels().encipher);
+}
+
+/**
+ * @brief DecipherKey
+ * @details Counterpart of EncipherKey
+ */
+inline void DecipherKey(const uchar* src, uchar* dst, size_t size, const uchar* key, uint n_rounds, ByteOrder order) noexcept {
+    if (n_rounds > STACK_ROUNDS) {
+        const Context ctx(key, n_rounds, order);
+        DecipherData(src, dst, size, ctx.DecipherSchedule(), Kernels().decipher);
+        return;
+    }
+    const Key k(key, order);
+    uint32_t round_keys[2 * STACK_ROUNDS];
+    ExpandKey(k.w, n_rounds, round_keys, true, DEFAULT_ALGORITHM);
+    DecipherData(src, dst, size, { k.w, round_keys, n_rounds, order, DEFAULT_ALGORITHM }, Kernels().decipher);
+}
+
+} // namespace Detail
+
+/**
+ * @brief Encrypt
+ * @details Out-of-place variant, see Encrypt(const void*, void*, size_t, const Context&)
+ * @param src Pointer to the data that will be encrypted
+ * @param dst Pointer to where the encrypted data is written, src or a separate buffer
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param key Any 128-bit block
+ * @param n_rounds Number of rounds
+ * @param order Byte order of the words of the key and of the data blocks
+ */
+inline void Encrypt(const void* src, void* dst, size_t size, const uchar* key, uint n_rounds = 32,
+                    ByteOrder order = ByteOrder::Little) noexcept {
+    Detail::EncipherKey((const uchar*)src, (uchar*)dst, Detail::WholeBlocks(size), key, n_rounds, order);
+}
+
+/**
+ * @brief Encrypt
+ * @param data Pointer to the data that will be encrypted. No additional data will be created
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE:
+ * a partial last block is left as is, see the variants with a Tail for other sizes
+ * @param key Any 128-bit block
+ * @param n_rounds Number of rounds. More rounds means
+ * better cryptographic strength and is therefore slower execution time
+ * @param order Byte order of the words of the key and of the data blocks
+ */
+inline void Encrypt(uchar* data, size_t size, uchar* key, uint n_rounds = 32, ByteOrder order = ByteOrder::Little) noexcept {
+    Detail::EncipherKey(data, data, size, key, n_rounds, order);
+}
+
+/**
+ * @brief Decrypt
+ * @details Out-of-place variant, see Decrypt(const void*, void*, size_t, const Context&)
+ * @param src Pointer to the data that will be decrypted
+ * @param dst Pointer to where the decrypted data is written, src or a separate buffer
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param key Any 128-bit block which was used to encrypt
+ * @param n_rounds Number of rounds which was used to encrypt
+ * @param order Byte order which was used to encrypt
+ */
+inline void Decrypt(const void* src, void* dst, size_t size, const uchar* key, uint n_rounds = 32,
+                    ByteOrder order = ByteOrder::Little) noexcept {
+    Detail::DecipherKey((const uchar*)src, (uchar*)dst, Detail::WholeBlocks(size), key, n_rounds, order);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Pointer to the data that will be encrypted.
+ * @param size Size of data provided in bytes. Must be multiple of XTEA_BLOCK_SIZE:
+ * a partial last block is left as is, see the variants with a Tail for other sizes
+ * @param key Any 128-bit block which was used to encipher
+ * @param n_rounds Number of rounds which was used to encrypt
+ * @param order Byte order which was used to encrypt
+ */
+inline void Decrypt(uchar* data, size_t size, uchar* key, uint n_rounds = 32, ByteOrder order = ByteOrder::Little) noexcept {
+    Detail::DecipherKey(data, data, size, key, n_rounds, order);
+}
+
+/**
+ * @brief Encrypt
+ * @details Variant with the rounds unrolled for a number of rounds known at compile time
+ * @tparam Rounds Number of rounds
+ * @param data Pointer to the data that will be encrypted. No additional data will be created
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE:
+ * a partial last block is left as is, see the variants with a Tail for other sizes
+ * @param key Any 128-bit block
+ * @param order Byte order of the words of the key and of the data blocks
+ */
+template<uint Rounds>
+inline void Encrypt(uchar* data, size_t size, uchar* key, ByteOrder order = ByteOrder::Little) noexcept {
+    static_assert(Rounds > 0, "Rounds must be positive");
+    const Detail::Key k(key, order);
+    uint32_t round_keys[2 * Rounds];
+    Xtea::ExpandKey(k.w, Rounds, round_keys, false);
+    const Detail::BulkFn bulk = order == ByteOrder::Big ? Detail::UnrolledEncipher<Rounds, ByteOrder::Big>(ActiveKernel())
+                                                        : Detail::UnrolledEncipher<Rounds, ByteOrder::Little>(ActiveKernel());
+    Detail::EncipherData<Rounds>(data, data, size, { k.w, round_keys, Rounds, order, Algorithm::Xtea }, bulk);
+}
+
+/**
+ * @brief Decrypt
+ * @details Variant with the rounds unrolled for a number of rounds known at compile time
+ * @tparam Rounds Number of rounds which was used to encrypt
+ * @param data Pointer to the data that will be decrypted
+ * @param size Size of data provided in bytes. Must be multiple of XTEA_BLOCK_SIZE:
+ * a partial last block is left as is, see the variants with a Tail for other sizes
+ * @param key Any 128-bit block which was used to encipher
+ * @param order Byte order which was used to encrypt
+ */
+template<uint Rounds>
+inline void Decrypt(uchar* data, size_t size, uchar* key, ByteOrder order = ByteOrder::Little) noexcept {
+    static_assert(Rounds > 0, "Rounds must be positive");
+    const Detail::Key k(key, order);
+    uint32_t round_keys[2 * Rounds];
+    Xtea::ExpandKey(k.w, Rounds, round_keys, true);
+    const Detail::BulkFn bulk = order == ByteOrder::Big ? Detail::UnrolledDecipher<Rounds, ByteOrder::Big>(ActiveKernel())
+                                                        : Detail::UnrolledDecipher<Rounds, ByteOrder::Little>(ActiveKernel());
+    Detail::DecipherData<Rounds>(data, data, size, { k.w, round_keys, Rounds, order, Algorithm::Xtea }, bulk);
+}
+
+namespace Detail {
+
+template<class Threads>
+inline void CtrParallel(uchar* data, size_t size, const Context& ctx, uint64_t nonce, uint64_t offset, const Threads& threads) {
+    const Schedule s = ctx.EncipherSchedule();
+    const CtrFn bulk = Kernels().ctr;
+    uint64_t counter = nonce + offset / BLOCK_SIZE;
+    size_t skip = offset % BLOCK_SIZE;
+    if (skip != 0 && size != 0) {
+        size_t n = size < BLOCK_SIZE - skip ? size : BLOCK_SIZE - skip;
+        CtrXor(data, n, skip, counter++, s);
+        data += n;
+        size -= n;
+    }
+    const size_t n_blocks = size / BLOCK_SIZE;
+    const size_t chunk = ParallelChunk(n_blocks, PARALLEL_GRAIN, threads);
+    ParallelFor(n_blocks, chunk, threads, [&](size_t begin, size_t end) {
+        CtrData(data + BLOCK_SIZE * begin, end - begin, s, counter + begin, bulk);
+    }, data);
+    if (size % BLOCK_SIZE != 0) {
+        CtrXor(data + BLOCK_SIZE * n_blocks, size % BLOCK_SIZE, 0, counter + n_blocks, s);
+    }
+}
+
+template<class Threads>
+inline void DecipherCbcParallel(uchar* data, size_t size, const Context& ctx, const uchar iv[BLOCK_SIZE], const Threads& threads) {
+    const Schedule s = ctx.DecipherSchedule();
+    const BulkFn bulk = Kernels().decipher;
+    const size_t n_blocks = size / BLOCK_SIZE;
+    if (n_blocks == 0) return;
+    const size_t chunk = ParallelChunk(n_blocks, PARALLEL_GRAIN, threads);
+    // Ciphertext blocks preceding each range, saved before any of them is overwritten
+    std::vector<uchar> prev(BLOCK_SIZE);
+    memcpy(prev.data(), iv, BLOCK_SIZE);
+    for (size_t begin = chunk; begin < n_blocks; begin += chunk) {
+        prev.insert(prev.end(), data + BLOCK_SIZE * (begin - 1), data + BLOCK_SIZE * begin);
+    }
+    ParallelFor(n_blocks, chunk, threads, [&](size_t begin, size_t end) {
+        DecipherCbc(data + BLOCK_SIZE * begin, end - begin, s, prev.data() + BLOCK_SIZE * (begin / chunk), bulk);
+    }, data);
+}
+
+} // namespace Detail
+
+/**
+ * @brief EncryptCtr
+ * @details Counter (CTR) mode. Block i of the keystream is the encipherment of the
+ * 64-bit counter nonce + i (wrapping), low 32 bits in v[0] and high 32 bits in v[1],
+ * and is XORed into the data. Works on any size without padding and can start at
+ * any position of the stream. Encryption and decryption are the same operation.
+ * A nonce must never be reused with the same key for overlapping counter ranges
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. Any size
+ * @param ctx Expanded key
+ * @param nonce Initial 64-bit counter
+ * @param offset Position of data in the stream, in bytes
+ * @param n_threads Number of threads to spread large buffers over, 0 for the hardware concurrency
+ */
+inline void EncryptCtr(uchar* data, size_t size, const Context& ctx, uint64_t nonce, uint64_t offset = 0, uint n_threads = 1) {
+    Detail::CtrParallel(data, size, ctx, nonce, offset, n_threads);
+}
+
+/**
+ * @brief EncryptCtr
+ * @details Variant on threads of the caller, see EncryptCtr
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. Any size
+ * @param ctx Expanded key
+ * @param nonce Initial 64-bit counter
+ * @param offset Position of data in the stream, in bytes
+ * @param executor Runs the ranges of large buffers, see Executor
+ */
+inline void EncryptCtr(uchar* data, size_t size, const Context& ctx, uint64_t nonce, uint64_t offset, const Executor& executor) {
+    Detail::CtrParallel(data, size, ctx, nonce, offset, executor);
+}
+
+/**
+ * @brief DecryptCtr
+ * @details Same as EncryptCtr
+ */
+inline void DecryptCtr(uchar* data, size_t size, const Context& ctx, uint64_t nonce, uint64_t offset = 0, uint n_threads = 1) {
+    EncryptCtr(data, size, ctx, nonce, offset, n_threads);
+}
+
+/**
+ * @brief DecryptCtr
+ * @details Same as EncryptCtr
+ */
+inline void DecryptCtr(uchar* data, size_t size, const Context& ctx, uint64_t nonce, uint64_t offset, const Executor& executor) {
+    EncryptCtr(data, size, ctx, nonce, offset, executor);
+}
+
+/**
+ * @brief EncryptCbc
+ * @details Cipher block chaining (CBC) mode. Each block is XORed with the previous
+ * ciphertext block, or the IV for the first one, before it is enciphered.
+ * This is inherently serial; decryption is not, see DecryptCbc
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param iv Initialization vector, unpredictable for each message
+ */
+inline void EncryptCbc(uchar* data, size_t size, const Context& ctx, const uchar iv[BLOCK_SIZE]) noexcept {
+    Detail::EncipherCbc(data, size / BLOCK_SIZE, ctx.EncipherSchedule(), iv);
+}
+
+/**
+ * @brief DecryptCbc
+ * @details Every block only depends on two ciphertext blocks, so blocks are
+ * deciphered on the SIMD kernel and large buffers are spread over threads
+ * @param data Pointer to the data that will be decrypted in place
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param iv Initialization vector which was used to encrypt
+ * @param n_threads Number of threads to spread large buffers over, 0 for the hardware concurrency
+ */
+inline void DecryptCbc(uchar* data, size_t size, const Context& ctx, const uchar iv[BLOCK_SIZE], uint n_threads = 1) {
+    Detail::DecipherCbcParallel(data, size, ctx, iv, n_threads);
+}
+
+/**
+ * @brief DecryptCbc
+ * @details Variant on threads of the caller, see DecryptCbc
+ * @param data Pointer to the data that will be decrypted in place
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param iv Initialization vector which was used to encrypt
+ * @param executor Runs the ranges of large buffers, see Executor
+ */
+inline void DecryptCbc(uchar* data, size_t size, const Context& ctx, const uchar iv[BLOCK_SIZE], const Executor& executor) {
+    Detail::DecipherCbcParallel(data, size, ctx, iv, executor);
+}
+
+/**
+ * @brief EncryptCbcCs3
+ * @details CBC with ciphertext stealing, variant CS3 of NIST SP 800-38A Addendum:
+ * the ciphertext is exactly as long as the plaintext. The partial last block is
+ * zero padded and chained as usual, then the last two ciphertext blocks are swapped
+ * and the now last one is truncated to the size of the partial block. A message of
+ * exactly one block is plain CBC
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. At least XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param iv Initialization vector, unpredictable for each message
+ * @return false if size is less than XTEA_BLOCK_SIZE, in which case data is left as it is
+ */
+inline bool EncryptCbcCs3(uchar* data, size_t size, const Context& ctx, const uchar iv[BLOCK_SIZE]) noexcept {
+    if (size < BLOCK_SIZE) return false;
+    if (size == BLOCK_SIZE) {
+        EncryptCbc(data, size, ctx, iv);
+        return true;
+    }
+    // n - 1 whole blocks, then a last block of 1 to BLOCK_SIZE bytes
+    const size_t last = (size - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    const size_t rest = size - last;
+    EncryptCbc(data, last, ctx, iv);
+    uchar* prev = data + last - BLOCK_SIZE;
+    uchar v[BLOCK_SIZE];
+    memcpy(v, prev, BLOCK_SIZE);
+    for (size_t i = 0; i < rest; i++) v[i] ^= data[last + i];
+    memcpy(data + last, prev, rest);
+    Detail::EncipherBytes(prev, v, ctx.EncipherSchedule());
+    return true;
+}
+
+/**
+ * @brief DecryptCbcCs3
+ * @details The last two blocks are undone first, then everything before them
+ * goes through the parallel CBC decryption of DecryptCbc
+ * @param data Pointer to the data that will be decrypted in place
+ * @param size Size of data provided, in bytes. At least XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param iv Initialization vector which was used to encrypt
+ * @param n_threads Number of threads to spread large buffers over, 0 for the hardware concurrency
+ * @return false if size is less than XTEA_BLOCK_SIZE, in which case data is left as it is
+ */
+inline bool DecryptCbcCs3(uchar* data, size_t size, const Context& ctx, const uchar iv[BLOCK_SIZE], uint n_threads = 1) {
+    if (size < BLOCK_SIZE) return false;
+    if (size == BLOCK_SIZE) {
+        DecryptCbc(data, size, ctx, iv);
+        return true;
+    }
+    const size_t last = (size - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    const size_t rest = size - last;
+    uchar* stolen = data + last - BLOCK_SIZE;
+    const uchar* before = last > BLOCK_SIZE ? stolen - BLOCK_SIZE : iv;
+    // z = D(C[n]) is C[n-1] XOR the zero padded last plaintext block, so its
+    // bytes past rest are the part of C[n-1] that was not transmitted
+    const Detail::Schedule s = ctx.DecipherSchedule();
+    uchar z[BLOCK_SIZE], c[BLOCK_SIZE];
+    Detail::DecipherBytes(z, stolen, s);
+    memcpy(c, z, BLOCK_SIZE);
+    memcpy(c, data + last, rest);
+    for (size_t i = 0; i < rest; i++) data[last + i] ^= z[i];
+    Detail::DecipherBytes(c, c, s);
+    for (size_t i = 0; i < BLOCK_SIZE; i++) stolen[i] = c[i] ^ before[i];
+    if (last > BLOCK_SIZE) DecryptCbc(data, last - BLOCK_SIZE, ctx, iv, n_threads);
+    return true;
+}
+
+/**
+ * @brief EncryptCbc
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param key Any 128-bit block
+ * @param iv Initialization vector, unpredictable for each message
+ * @param n_rounds Number of rounds
+ */
+inline void EncryptCbc(uchar* data, size_t size, uchar* key, const uchar iv[BLOCK_SIZE], uint n_rounds = 32) {
+    EncryptCbc(data, size, Context(key, n_rounds), iv);
+}
+
+/**
+ * @brief DecryptCbc
+ * @param data Pointer to the data that will be decrypted in place
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param key Any 128-bit block which was used to encrypt
+ * @param iv Initialization vector which was used to encrypt
+ * @param n_rounds Number of rounds which was used to encrypt
+ */
+inline void DecryptCbc(uchar* data, size_t size, uchar* key, const uchar iv[BLOCK_SIZE], uint n_rounds = 32) {
+    DecryptCbc(data, size, Context(key, n_rounds), iv);
+}
+
+/**
+ * @brief EncryptCbcCs3
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. At least XTEA_BLOCK_SIZE
+ * @param key Any 128-bit block
+ * @param iv Initialization vector, unpredictable for each message
+ * @param n_rounds Number of rounds
+ * @return false if size is less than XTEA_BLOCK_SIZE
+ */
+inline bool EncryptCbcCs3(uchar* data, size_t size, uchar* key, const uchar iv[BLOCK_SIZE], uint n_rounds = 32) {
+    return EncryptCbcCs3(data, size, Context(key, n_rounds), iv);
+}
+
+/**
+ * @brief DecryptCbcCs3
+ * @param data Pointer to the data that will be decrypted in place
+ * @param size Size of data provided, in bytes. At least XTEA_BLOCK_SIZE
+ * @param key Any 128-bit block which was used to encrypt
+ * @param iv Initialization vector which was used to encrypt
+ * @param n_rounds Number of rounds which was used to encrypt
+ * @return false if size is less than XTEA_BLOCK_SIZE
+ */
+inline bool DecryptCbcCs3(uchar* data, size_t size, uchar* key, const uchar iv[BLOCK_SIZE], uint n_rounds = 32) {
+    return DecryptCbcCs3(data, size, Context(key, n_rounds), iv);
+}
+
+/**
+ * @brief EncryptBatch
+ * @details Encrypts many messages, each under its own key, like a call of Encrypt
+ * per message would. Blocks of different messages share the SIMD lanes,
+ * so short messages go as fast as long ones
+ * @param messages Messages to encrypt in place
+ * @param n_messages Number of messages
+ * @param n_rounds Number of rounds, the same for every message
+ * @param algorithm XTEA or TEA, the same for every message
+ */
+inline void EncryptBatch(const Message* messages, size_t n_messages, uint n_rounds = 32, Algorithm algorithm = DEFAULT_ALGORITHM) noexcept {
+    Detail::MultiData(messages, n_messages, n_rounds, algorithm, Detail::Kernels().encipher_multi);
+}
+
+/**
+ * @brief DecryptBatch
+ * @param messages Messages to decrypt in place
+ * @param n_messages Number of messages
+ * @param n_rounds Number of rounds which was used to encrypt
+ * @param algorithm Algorithm which was used to encrypt
+ */
+inline void DecryptBatch(const Message* messages, size_t n_messages, uint n_rounds = 32, Algorithm algorithm = DEFAULT_ALGORITHM) noexcept {
+    Detail::MultiData(messages, n_messages, n_rounds, algorithm, Detail::Kernels().decipher_multi);
+}
+
+namespace Detail {
+
+/**
+ * @brief SMALL_MESSAGE
+ * @details Messages of fewer blocks go through the multi-key lanes along with
+ * their neighbours, larger ones through the bulk kernel under their own schedule
+ */
+constexpr const size_t SMALL_MESSAGE = 512;
+
+/**
+ * @brief STEAL_ITEM
+ * @details Blocks of one item of work of a parallel batch: large messages are split
+ * into ranges of this many blocks, runs of small messages are cut once they have as many
+ */
+constexpr const size_t STEAL_ITEM = 8192;
+
+/**
+ * @brief BatchItem
+ * @details count small messages from message on, or blocks [begin, end) of message if count is 0
+ */
+struct BatchItem {
+    size_t message;
+    size_t count;
+    size_t begin;
+    size_t end;
+};
+
+/**
+ * @brief StealQueue
+ * @details Items of one worker of a parallel batch. The worker takes them from the front,
+ * in the order of the data; workers which ran out of their own steal from the back
+ */
+class StealQueue {
+public:
+    void Push(const BatchItem& item) { items_.push_back(item); }
+
+    bool Pop(BatchItem& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty()) return false;
+        item = items_.front();
+        items_.pop_front();
+        return true;
+    }
+
+    bool Steal(BatchItem& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty()) return false;
+        item = items_.back();
+        items_.pop_back();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<BatchItem> items_;
+};
+
+/**
+ * @brief SplitBatch
+ * @details Items of work of a batch: ranges of STEAL_ITEM blocks of the large messages
+ * and runs of consecutive small messages of about STEAL_ITEM blocks in total
+ */
+inline std::vector<BatchItem> SplitBatch(const Message* messages, size_t n_messages) {
+    std::vector<BatchItem> items;
+    size_t run = 0, run_blocks = 0;
+    for (size_t m = 0; m < n_messages; m++) {
+        const size_t n_blocks = messages[m].size / BLOCK_SIZE;
+        if (n_blocks < SMALL_MESSAGE) {
+            run_blocks += n_blocks;
+            if (run_blocks >= STEAL_ITEM) {
+                items.push_back({ run, m + 1 - run, 0, 0 });
+                run = m + 1;
+                run_blocks = 0;
+            }
+            continue;
+        }
+        if (m > run) items.push_back({ run, m - run, 0, 0 });
+        for (size_t begin = 0; begin < n_blocks; begin += STEAL_ITEM) {
+            items.push_back({ m, 0, begin, n_blocks - begin > STEAL_ITEM ? begin + STEAL_ITEM : n_blocks });
+        }
+        run = m + 1;
+        run_blocks = 0;
+    }
+    if (n_messages > run) items.push_back({ run, n_messages - run, 0, 0 });
+    return items;
+}
+
+/**
+ * @brief BatchRange
+ * @details Enciphers or deciphers blocks [begin, end) of a large message in place
+ */
+inline void BatchRange(const Message& message, size_t begin, size_t end, uint n_rounds, Algorithm algorithm,
+                       bool inverse, BulkFn bulk) {
+    const Key k(message.key);
+    uchar* data = message.data + BLOCK_SIZE * begin;
+    const size_t size = BLOCK_SIZE * (end - begin);
+    if (n_rounds > STACK_ROUNDS) {
+        const Context ctx(k.w, n_rounds, ByteOrder::Little, algorithm);
+        if (inverse) DecipherData(data, data, size, ctx.DecipherSchedule(), bulk);
+        else EncipherData(data, data, size, ctx.EncipherSchedule(), bulk);
+        return;
+    }
+    uint32_t round_keys[2 * STACK_ROUNDS];
+    ExpandKey(k.w, n_rounds, round_keys, inverse, algorithm);
+    const Schedule s = { k.w, round_keys, n_rounds, ByteOrder::Little, algorithm };
+    if (inverse) DecipherData(data, data, size, s, bulk);
+    else EncipherData(data, data, size, s, bulk);
+}
+
+inline uint BatchWorkers(uint n_threads) noexcept {
+    return n_threads ? n_threads : std::thread::hardware_concurrency();
+}
+
+inline uint BatchWorkers(const Executor& executor) noexcept {
+    return BatchWorkers(executor.threads);
+}
+
+/**
+ * @brief BatchParallel
+ * @details Deals the items of the batch out to a StealQueue per worker, in consecutive
+ * shares, and runs the workers, each working through its own queue and then stealing
+ * from the others until all are empty, so they finish together however the sizes mix
+ */
+template<class Threads>
+inline void BatchParallel(const Message* messages, size_t n_messages, uint n_rounds, Algorithm algorithm,
+                          bool inverse, const Threads& threads) {
+    const std::vector<BatchItem> items = SplitBatch(messages, n_messages);
+    if (items.empty()) return;
+    size_t n_workers = BatchWorkers(threads);
+    if (n_workers > items.size()) n_workers = items.size();
+    if (n_workers == 0) n_workers = 1;
+    std::vector<StealQueue> queues(n_workers);
+    for (size_t w = 0; w < n_workers; w++) {
+        for (size_t i = items.size() * w / n_workers; i < items.size() * (w + 1) / n_workers; i++) queues[w].Push(items[i]);
+    }
+    const KernelTable& kernels = Kernels();
+    const BulkFn bulk = inverse ? kernels.decipher : kernels.encipher;
+    const MultiFn multi = inverse ? kernels.decipher_multi : kernels.encipher_multi;
+    const auto worker = [&](size_t w) {
+        BatchItem item;
+        for (;;) {
+            bool found = queues[w].Pop(item);
+            for (size_t k = 1; !found && k < n_workers; k++) found = queues[(w + k) % n_workers].Steal(item);
+            if (!found) return;
+            if (item.count) MultiData(messages + item.message, item.count, n_rounds, algorithm, multi);
+            else BatchRange(messages[item.message], item.begin, item.end, n_rounds, algorithm, inverse, bulk);
+        }
+    };
+    RunTask(Task(n_workers, worker), threads);
+}
+
+} // namespace Detail
+
+/**
+ * @brief EncryptBatch
+ * @details Multithreaded variant for batches mixing messages of very different sizes.
+ * Large messages are split into ranges encrypted with the bulk kernel, runs of small
+ * ones are encrypted together in the multi-key lanes, and the pieces are balanced
+ * over the threads by work stealing
+ * @param messages Messages to encrypt in place
+ * @param n_messages Number of messages
+ * @param n_rounds Number of rounds, the same for every message
+ * @param algorithm XTEA or TEA, the same for every message
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void EncryptBatch(const Message* messages, size_t n_messages, uint n_rounds, Algorithm algorithm, uint n_threads) {
+    Detail::BatchParallel(messages, n_messages, n_rounds, algorithm, false, n_threads);
+}
+
+/**
+ * @brief EncryptBatch
+ * @details Multithreaded variant on threads of the caller, see EncryptBatch
+ * @param messages Messages to encrypt in place
+ * @param n_messages Number of messages
+ * @param n_rounds Number of rounds, the same for every message
+ * @param algorithm XTEA or TEA, the same for every message
+ * @param executor Runs the workers, see Executor
+ */
+inline void EncryptBatch(const Message* messages, size_t n_messages, uint n_rounds, Algorithm algorithm, const Executor& executor) {
+    Detail::BatchParallel(messages, n_messages, n_rounds, algorithm, false, executor);
+}
+
+/**
+ * @brief DecryptBatch
+ * @details Multithreaded variant, see EncryptBatch
+ * @param messages Messages to decrypt in place
+ * @param n_messages Number of messages
+ * @param n_rounds Number of rounds which was used to encrypt
+ * @param algorithm Algorithm which was used to encrypt
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void DecryptBatch(const Message* messages, size_t n_messages, uint n_rounds, Algorithm algorithm, uint n_threads) {
+    Detail::BatchParallel(messages, n_messages, n_rounds, algorithm, true, n_threads);
+}
+
+/**
+ * @brief DecryptBatch
+ * @details Multithreaded variant on threads of the caller, see EncryptBatch
+ * @param messages Messages to decrypt in place
+ * @param n_messages Number of messages
+ * @param n_rounds Number of rounds which was used to encrypt
+ * @param algorithm Algorithm which was used to encrypt
+ * @param executor Runs the workers, see Executor
+ */
+inline void DecryptBatch(const Message* messages, size_t n_messages, uint n_rounds, Algorithm algorithm, const Executor& executor) {
+    Detail::BatchParallel(messages, n_messages, n_rounds, algorithm, true, executor);
+}
+
+namespace Detail {
+
+/**
+ * @brief IsXxteaSize
+ * @return Whether XXTEA can take size bytes as one block: whole words, at least two
+ */
+inline bool IsXxteaSize(size_t size) noexcept {
+    return size % 4 == 0 && size >= 8;
+}
+
+template<bool Inverse>
+inline void XxteaBytes(uchar* data, size_t n_words, const XxteaContext& ctx) noexcept {
+    const XxteaSchedule& s = ctx.KeySchedule();
+    if (ctx.Order() == ByteOrder::Big) {
+        if (Inverse) Xxtea::Decipher(ByteWords<ByteOrder::Big>{ data }, n_words, s);
+        else Xxtea::Encipher(ByteWords<ByteOrder::Big>{ data }, n_words, s);
+    } else {
+        if (Inverse) Xxtea::Decipher(ByteWords<ByteOrder::Little>{ data }, n_words, s);
+        else Xxtea::Encipher(ByteWords<ByteOrder::Little>{ data }, n_words, s);
+    }
+}
+
+/**
+ * @brief XxteaData
+ * @details Runs the messages through the lanes of the kernel, as many at a time as
+ * it has, and the remaining ones one by one in place
+ */
+template<bool Inverse>
+inline void XxteaData(uchar* const data[], size_t n_messages, size_t n_words, const XxteaContext& ctx, XxteaFn lanes) {
+    size_t m = 0;
+    if (lanes != XxteaScalar && n_messages > 1) {
+        // Sized for the widest kernel, which has MULTI_LANES lanes
+        std::vector<uint32_t> scratch(MULTI_LANES * n_words);
+        m = lanes(data, n_messages, n_words, ctx.KeySchedule(), ctx.Order(), scratch.data());
+    }
+    for (; m < n_messages; m++) XxteaBytes<Inverse>(data[m], n_words, ctx);
+}
+
+} // namespace Detail
+
+/**
+ * @brief Encrypt
+ * @details XXTEA over the whole data as a single block, so no padding is needed
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. Multiple of 4 and at least 8
+ * @param ctx Expanded XXTEA key
+ * @return false if size is not a multiple of 4 or is less than 8
+ */
+inline bool Encrypt(void* data, size_t size, const XxteaContext& ctx) noexcept {
+    if (!Detail::IsXxteaSize(size)) return false;
+    Detail::XxteaBytes<false>((uchar*)data, size / 4, ctx);
+    return true;
+}
+
+/**
+ * @brief Decrypt
+ * @param data Pointer to the data that will be decrypted in place
+ * @param size Size of data provided, in bytes. Multiple of 4 and at least 8
+ * @param ctx Expanded XXTEA key which was used to encrypt
+ * @return false if size is not a multiple of 4 or is less than 8
+ */
+inline bool Decrypt(void* data, size_t size, const XxteaContext& ctx) noexcept {
+    if (!Detail::IsXxteaSize(size)) return false;
+    Detail::XxteaBytes<true>((uchar*)data, size / 4, ctx);
+    return true;
+}
+
+/**
+ * @brief EncryptBatch
+ * @details Encrypts many messages of the same size with XXTEA, each as a single block
+ * like a call of Encrypt per message would. The messages share the SIMD lanes, one per lane
+ * @param messages Pointers to the messages to encrypt in place
+ * @param n_messages Number of messages
+ * @param size Size of every message, in bytes. Multiple of 4 and at least 8
+ * @param ctx Expanded XXTEA key, the same for every message
+ * @return false if size is not a multiple of 4 or is less than 8
+ */
+inline bool EncryptBatch(uchar* const messages[], size_t n_messages, size_t size, const XxteaContext& ctx) {
+    if (!Detail::IsXxteaSize(size)) return false;
+    Detail::XxteaData<false>(messages, n_messages, size / 4, ctx, Detail::Kernels().encipher_xxtea);
+    return true;
+}
+
+/**
+ * @brief DecryptBatch
+ * @param messages Pointers to the messages to decrypt in place
+ * @param n_messages Number of messages
+ * @param size Size of every message, in bytes. Multiple of 4 and at least 8
+ * @param ctx Expanded XXTEA key which was used to encrypt
+ * @return false if size is not a multiple of 4 or is less than 8
+ */
+inline bool DecryptBatch(uchar* const messages[], size_t n_messages, size_t size, const XxteaContext& ctx) {
+    if (!Detail::IsXxteaSize(size)) return false;
+    Detail::XxteaData<true>(messages, n_messages, size / 4, ctx, Detail::Kernels().decipher_xxtea);
+    return true;
+}
+
+/**
+ * @brief CbcJob
+ * @details One CBC message for CbcMultiBuffer. data, key and the job itself
+ * must stay valid until the scheduler hands the job back
+ */
+struct CbcJob {
+    uchar* data;          ///< Encrypted in place
+    size_t size;          ///< In bytes, multiple of XTEA_BLOCK_SIZE
+    const uchar* key;     ///< Any 128-bit block
+    uchar iv[BLOCK_SIZE]; ///< Replaced by the last ciphertext block once done, to chain the next message
+    void* user;           ///< Left alone by the scheduler
+};
+
+/**
+ * @brief CbcMultiBuffer
+ * @details Multi-buffer CBC encryption. A single CBC message is serial, but up to
+ * LANES messages under different keys are advanced together, one block of each
+ * per SIMD pass. Jobs are submitted as they come and handed back as soon as they
+ * are done, in no particular order. Not thread safe; use one scheduler per thread
+ */
+class CbcMultiBuffer {
+public:
+    static constexpr const uint LANES = Detail::MULTI_LANES;
+
+    /**
+     * @brief CbcMultiBuffer
+     * @param n_rounds Number of rounds of every job
+     * @param algorithm XTEA or TEA, for every job
+     */
+    explicit CbcMultiBuffer(uint n_rounds = 32, Algorithm algorithm = DEFAULT_ALGORITHM) noexcept
+        : n_rounds_(n_rounds), algorithm_(algorithm), n_done_(0) {
+        memset(jobs_, 0, sizeof(jobs_));
+        memset(v0_, 0, sizeof(v0_));
+        memset(v1_, 0, sizeof(v1_));
+        memset(key_, 0, sizeof(key_));
+    }
+
+    /**
+     * @brief Submit
+     * @details Puts job in a free lane. Once every lane is busy, all of them are
+     * advanced until at least one job is done
+     * @return A job that is done, or nullptr if none is yet
+     */
+    CbcJob* Submit(CbcJob* job) noexcept {
+        if (job->size < BLOCK_SIZE) return job;
+        uint lane = 0;
+        while (jobs_[lane]) lane++;
+        jobs_[lane] = job;
+        next_[lane] = job->data;
+        remaining_[lane] = job->size / BLOCK_SIZE;
+        v0_[lane] = Detail::LoadWord(job->iv);
+        v1_[lane] = Detail::LoadWord(job->iv + 4);
+        for (uint w = 0; w < 4; w++) key_[LANES * w + lane] = Detail::LoadWord(job->key + 4 * w);
+        if (Active() == LANES) Run();
+        return Retrieve();
+    }
+
+    /**
+     * @brief Flush
+     * @details Advances the busy lanes, with the others idle, until a job is done
+     * @return A job that is done, or nullptr once the scheduler is empty
+     */
+    CbcJob* Flush() noexcept {
+        if (n_done_ == 0 && Active() != 0) Run();
+        return Retrieve();
+    }
+
+    /**
+     * @brief Active
+     * @return Number of busy lanes
+     */
+    uint Active() const noexcept {
+        uint n = 0;
+        for (uint lane = 0; lane < LANES; lane++) n += jobs_[lane] != nullptr;
+        return n;
+    }
+
+private:
+    void Run() noexcept {
+        size_t n = (size_t)-1;
+        for (uint lane = 0; lane < LANES; lane++) {
+            if (jobs_[lane] && remaining_[lane] < n) n = remaining_[lane];
+        }
+        const Detail::MultiFn encipher = Detail::Kernels().encipher_multi;
+        for (size_t i = 0; i < n; i++) {
+            for (uint lane = 0; lane < LANES; lane++) {
+                if (!jobs_[lane]) continue;
+                v0_[lane] ^= Detail::LoadWord(next_[lane]);
+                v1_[lane] ^= Detail::LoadWord(next_[lane] + 4);
+            }
+            encipher(v0_, v1_, key_, n_rounds_, algorithm_);
+            for (uint lane = 0; lane < LANES; lane++) {
+                if (!jobs_[lane]) continue;
+                Detail::StoreWord(next_[lane], v0_[lane]);
+                Detail::StoreWord(next_[lane] + 4, v1_[lane]);
+                next_[lane] += BLOCK_SIZE;
+            }
+        }
+        for (uint lane = 0; lane < LANES; lane++) {
+            if (!jobs_[lane] || (remaining_[lane] -= n) != 0) continue;
+            memcpy(jobs_[lane]->iv, next_[lane] - BLOCK_SIZE, BLOCK_SIZE);
+            done_[n_done_++] = jobs_[lane];
+            jobs_[lane] = nullptr;
+        }
+    }
+
+    CbcJob* Retrieve() noexcept {
+        return n_done_ ? done_[--n_done_] : nullptr;
+    }
+
+    uint n_rounds_;
+    Algorithm algorithm_;
+    CbcJob* jobs_[LANES];
+    uchar* next_[LANES];
+    size_t remaining_[LANES];
+    uint32_t v0_[LANES];
+    uint32_t v1_[LANES];
+    uint32_t key_[4 * LANES];
+    // Lanes plus done jobs never exceed LANES, since a job is only handed back
+    // by Submit or Flush and Submit only runs the lanes once all are busy
+    CbcJob* done_[LANES];
+    uint n_done_;
+};
+
+/**
+ * @brief EncryptCtr
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. Any size
+ * @param key Any 128-bit block
+ * @param nonce Initial 64-bit counter
+ * @param n_rounds Number of rounds
+ */
+inline void EncryptCtr(uchar* data, size_t size, uchar* key, uint64_t nonce, uint n_rounds = 32) {
+    EncryptCtr(data, size, Context(key, n_rounds), nonce);
+}
+
+/**
+ * @brief DecryptCtr
+ * @details Same as EncryptCtr
+ */
+inline void DecryptCtr(uchar* data, size_t size, uchar* key, uint64_t nonce, uint n_rounds = 32) {
+    EncryptCtr(data, size, Context(key, n_rounds), nonce);
+}
+
+#ifdef XTEA_HAS_MMAP
+
+namespace Detail {
+
+/**
+ * @brief FILE_WINDOW
+ * @details Bytes of a mapped file encrypted and written back at a time, 64 MiB,
+ * so that the dirty pages of a large file don't pile up in memory
+ */
+constexpr const size_t FILE_WINDOW = (size_t)64 << 20;
+
+/**
+ * @brief MapFile
+ * @details Maps the file at path for reading and writing and calls fn(data, offset, length)
+ * for each FILE_WINDOW of it in turn, writing each window back with msync before
+ * the next one. The mapping is advised to be read sequentially and, where the file
+ * system supports it, backed by huge pages
+ * @param multiple The file size must be a multiple of it
+ * @return False if the file can't be opened, mapped or written back, or has the wrong size
+ */
+template<class Fn>
+inline bool MapFile(const char* path, size_t multiple, const Fn& fn) {
+    const int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (off_t)(size_t)st.st_size != st.st_size ||
+        (size_t)st.st_size % multiple != 0) {
+        close(fd);
+        return false;
+    }
+    const size_t size = (size_t)st.st_size;
+    void* map = size == 0 ? nullptr : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (size == 0) return true;
+    if (map == MAP_FAILED) return false;
+    madvise(map, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    madvise(map, size, MADV_HUGEPAGE);
+#endif
+    bool written = true;
+    try {
+        for (size_t offset = 0; offset < size && written; offset += FILE_WINDOW) {
+            const size_t length = size - offset < FILE_WINDOW ? size - offset : FILE_WINDOW;
+            uchar* window = (uchar*)map + offset;
+            fn(window, offset, length);
+            written = msync(window, length, MS_SYNC) == 0;
+        }
+    } catch (...) {
+        munmap(map, size);
+        throw;
+    }
+    return munmap(map, size) == 0 && written;
+}
+
+} // namespace Detail
+
+/**
+ * @brief EncryptFile
+ * @details Encrypts a file in place through a shared memory mapping, without copying it
+ * to a buffer or holding all of it in memory: windows of 64 MiB are encrypted by the
+ * multithreaded Encrypt and written back with msync one after the other. The file must
+ * not be truncated meanwhile. On failure, part of the file may already be encrypted
+ * @param path Path of the file. Its size must be a multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ * @return False if the file can't be opened, mapped or written back, or its size is not
+ * a multiple of XTEA_BLOCK_SIZE
+ */
+inline bool EncryptFile(const char* path, const Context& ctx, uint n_threads = 0) {
+    return Detail::MapFile(path, BLOCK_SIZE, [&](uchar* data, size_t, size_t length) {
+        Detail::EncipherParallel(data, data, length, ctx, n_threads);
+    });
+}
+
+/**
+ * @brief EncryptFile
+ * @details Variant on threads of the caller, see EncryptFile
+ * @param path Path of the file. Its size must be a multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param executor Runs the ranges, see Executor
+ */
+inline bool EncryptFile(const char* path, const Context& ctx, const Executor& executor) {
+    return Detail::MapFile(path, BLOCK_SIZE, [&](uchar* data, size_t, size_t length) {
+        Detail::EncipherParallel(data, data, length, ctx, executor);
+    });
+}
+
+/**
+ * @brief DecryptFile
+ * @details Decrypts a file in place, see EncryptFile
+ * @param path Path of the file. Its size must be a multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline bool DecryptFile(const char* path, const Context& ctx, uint n_threads = 0) {
+    return Detail::MapFile(path, BLOCK_SIZE, [&](uchar* data, size_t, size_t length) {
+        Detail::DecipherParallel(data, data, length, ctx, n_threads);
+    });
+}
+
+/**
+ * @brief DecryptFile
+ * @details Variant on threads of the caller, see EncryptFile
+ * @param path Path of the file. Its size must be a multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param executor Runs the ranges, see Executor
+ */
+inline bool DecryptFile(const char* path, const Context& ctx, const Executor& executor) {
+    return Detail::MapFile(path, BLOCK_SIZE, [&](uchar* data, size_t, size_t length) {
+        Detail::DecipherParallel(data, data, length, ctx, executor);
+    });
+}
+
+/**
+ * @brief EncryptFileCtr
+ * @details Encrypts a file of any size in place in counter mode, see EncryptCtr and EncryptFile
+ * @param path Path of the file
+ * @param ctx Expanded key
+ * @param nonce Initial 64-bit counter
+ * @param offset Position of the file in the stream, in bytes
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ * @return False if the file can't be opened, mapped or written back
+ */
+inline bool EncryptFileCtr(const char* path, const Context& ctx, uint64_t nonce, uint64_t offset = 0, uint n_threads = 0) {
+    return Detail::MapFile(path, 1, [&](uchar* data, size_t position, size_t length) {
+        Detail::CtrParallel(data, length, ctx, nonce, offset + position, n_threads);
+    });
+}
+
+/**
+ * @brief EncryptFileCtr
+ * @details Variant on threads of the caller, see EncryptFileCtr
+ * @param path Path of the file
+ * @param ctx Expanded key
+ * @param nonce Initial 64-bit counter
+ * @param offset Position of the file in the stream, in bytes
+ * @param executor Runs the ranges, see Executor
+ */
+inline bool EncryptFileCtr(const char* path, const Context& ctx, uint64_t nonce, uint64_t offset, const Executor& executor) {
+    return Detail::MapFile(path, 1, [&](uchar* data, size_t position, size_t length) {
+        Detail::CtrParallel(data, length, ctx, nonce, offset + position, executor);
+    });
+}
+
+/**
+ * @brief DecryptFileCtr
+ * @details Same as EncryptFileCtr
+ */
+inline bool DecryptFileCtr(const char* path, const Context& ctx, uint64_t nonce, uint64_t offset = 0, uint n_threads = 0) {
+    return EncryptFileCtr(path, ctx, nonce, offset, n_threads);
+}
+
+/**
+ * @brief DecryptFileCtr
+ * @details Same as EncryptFileCtr
+ */
+inline bool DecryptFileCtr(const char* path, const Context& ctx, uint64_t nonce, uint64_t offset, const Executor& executor) {
+    return EncryptFileCtr(path, ctx, nonce, offset, executor);
+}
+
+#endif /* ifdef(XTEA_HAS_MMAP) */
+
+#ifdef __cpp_lib_span
+
+/**
+ * @brief Encrypt
+ * @param data Data that will be encrypted in place, size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void Encrypt(std::span<std::byte> data, const Context& ctx, uint n_threads = 1) {
+    Encrypt(data.data(), data.data(), data.size(), ctx, n_threads);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Data that will be decrypted in place, size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void Decrypt(std::span<std::byte> data, const Context& ctx, uint n_threads = 1) {
+    Decrypt(data.data(), data.data(), data.size(), ctx, n_threads);
+}
+
+/**
+ * @brief Encrypt
+ * @param src Data that will be encrypted, size multiple of XTEA_BLOCK_SIZE
+ * @param dst Where the encrypted data is written, at least as large as src
+ * @param ctx Expanded key
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void Encrypt(std::span<const std::byte> src, std::span<std::byte> dst, const Context& ctx, uint n_threads = 1) {
+    Encrypt(src.data(), dst.data(), src.size(), ctx, n_threads);
+}
+
+/**
+ * @brief Decrypt
+ * @param src Data that will be decrypted, size multiple of XTEA_BLOCK_SIZE
+ * @param dst Where the decrypted data is written, at least as large as src
+ * @param ctx Expanded key which was used to encrypt
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void Decrypt(std::span<const std::byte> src, std::span<std::byte> dst, const Context& ctx, uint n_threads = 1) {
+    Decrypt(src.data(), dst.data(), src.size(), ctx, n_threads);
+}
+
+/**
+ * @brief Encrypt
+ * @param data Data that will be encrypted in place, size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param executor Runs the ranges of large buffers, see Executor
+ */
+inline void Encrypt(std::span<std::byte> data, const Context& ctx, const Executor& executor) {
+    Encrypt(data.data(), data.data(), data.size(), ctx, executor);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Data that will be decrypted in place, size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param executor Runs the ranges of large buffers, see Executor
+ */
+inline void Decrypt(std::span<std::byte> data, const Context& ctx, const Executor& executor) {
+    Decrypt(data.data(), data.data(), data.size(), ctx, executor);
+}
+
+/**
+ * @brief Encrypt
+ * @param data Data that will be encrypted in place, size multiple of XTEA_BLOCK_SIZE
+ * @param key Any 128-bit block
+ * @param n_rounds Number of rounds
+ */
+inline void Encrypt(std::span<std::byte> data, std::span<const std::byte, 16> key, uint n_rounds = 32) noexcept {
+    Encrypt(data.data(), data.data(), data.size(), (const uchar*)key.data(), n_rounds);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Data that will be decrypted in place, size multiple of XTEA_BLOCK_SIZE
+ * @param key Any 128-bit block which was used to encrypt
+ * @param n_rounds Number of rounds which was used to encrypt
+ */
+inline void Decrypt(std::span<std::byte> data, std::span<const std::byte, 16> key, uint n_rounds = 32) noexcept {
+    Decrypt(data.data(), data.data(), data.size(), (const uchar*)key.data(), n_rounds);
+}
+
+/**
+ * @brief EncryptCtr
+ * @param data Data that will be encrypted in place, any size
+ * @param ctx Expanded key
+ * @param nonce Initial 64-bit counter
+ * @param offset Position of data in the stream, in bytes
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void EncryptCtr(std::span<std::byte> data, const Context& ctx, uint64_t nonce, uint64_t offset = 0, uint n_threads = 1) {
+    EncryptCtr((uchar*)data.data(), data.size(), ctx, nonce, offset, n_threads);
+}
+
+/**
+ * @brief DecryptCtr
+ * @details Same as EncryptCtr
+ */
+inline void DecryptCtr(std::span<std::byte> data, const Context& ctx, uint64_t nonce, uint64_t offset = 0, uint n_threads = 1) {
+    EncryptCtr((uchar*)data.data(), data.size(), ctx, nonce, offset, n_threads);
+}
+
+/**
+ * @brief EncryptCtr
+ * @param data Data that will be encrypted in place, any size
+ * @param ctx Expanded key
+ * @param nonce Initial 64-bit counter
+ * @param offset Position of data in the stream, in bytes
+ * @param executor Runs the ranges of large buffers, see Executor
+ */
+inline void EncryptCtr(std::span<std::byte> data, const Context& ctx, uint64_t nonce, uint64_t offset, const Executor& executor) {
+    EncryptCtr((uchar*)data.data(), data.size(), ctx, nonce, offset, executor);
+}
+
+/**
+ * @brief DecryptCtr
+ * @details Same as EncryptCtr
+ */
+inline void DecryptCtr(std::span<std::byte> data, const Context& ctx, uint64_t nonce, uint64_t offset, const Executor& executor) {
+    EncryptCtr((uchar*)data.data(), data.size(), ctx, nonce, offset, executor);
+}
+
+/**
+ * @brief Encrypt
+ * @details XXTEA over the whole data as a single block
+ * @param data Data that will be encrypted in place, size multiple of 4 and at least 8
+ * @param ctx Expanded XXTEA key
+ * @return false if the size of data is not a multiple of 4 or is less than 8
+ */
+inline bool Encrypt(std::span<std::byte> data, const XxteaContext& ctx) noexcept {
+    return Encrypt(data.data(), data.size(), ctx);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Data that will be decrypted in place, size multiple of 4 and at least 8
+ * @param ctx Expanded XXTEA key which was used to encrypt
+ * @return false if the size of data is not a multiple of 4 or is less than 8
+ */
+inline bool Decrypt(std::span<std::byte> data, const XxteaContext& ctx) noexcept {
+    return Decrypt(data.data(), data.size(), ctx);
+}
+
+/**
+ * @brief EncryptCbc
+ * @param data Data that will be encrypted in place, size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param iv Initialization vector, unpredictable for each message
+ */
+inline void EncryptCbc(std::span<std::byte> data, const Context& ctx, std::span<const std::byte, BLOCK_SIZE> iv) noexcept {
+    EncryptCbc((uchar*)data.data(), data.size(), ctx, (const uchar*)iv.data());
+}
+
+/**
+ * @brief DecryptCbc
+ * @param data Data that will be decrypted in place, size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param iv Initialization vector which was used to encrypt
+ * @param n_threads Number of threads, 0 for the hardware concurrency
+ */
+inline void DecryptCbc(std::span<std::byte> data, const Context& ctx, std::span<const std::byte, BLOCK_SIZE> iv, uint n_threads = 1) {
+    DecryptCbc((uchar*)data.data(), data.size(), ctx, (const uchar*)iv.data(), n_threads);
+}
+
+#endif /* ifdef(__cpp_lib_span) */
+
+#ifdef XTEA_HAS_EXECUTION
+
+/**
+ * @brief Encrypt
+ * @details Parallel variant on the standard parallel algorithms, see PolicyExecutor.
+ * Buffers too small to be split are encrypted on the calling thread
+ * @param policy Standard execution policy, e.g. std::execution::par_unseq
+ * @param src Pointer to the data that will be encrypted
+ * @param dst Pointer to where the encrypted data is written, src or a separate buffer
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ */
+template<class ExecutionPolicy, class = Detail::IfExecutionPolicy<ExecutionPolicy>>
+inline void Encrypt(ExecutionPolicy&& policy, const void* src, void* dst, size_t size, const Context& ctx) {
+    Encrypt(src, dst, size, ctx, PolicyExecutor<std::decay_t<ExecutionPolicy>>(policy));
+}
+
+/**
+ * @brief Decrypt
+ * @details Parallel variant on the standard parallel algorithms, see Encrypt
+ * @param policy Standard execution policy, e.g. std::execution::par_unseq
+ * @param src Pointer to the data that will be decrypted
+ * @param dst Pointer to where the decrypted data is written, src or a separate buffer
+ * @param size Size of data provided in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ */
+template<class ExecutionPolicy, class = Detail::IfExecutionPolicy<ExecutionPolicy>>
+inline void Decrypt(ExecutionPolicy&& policy, const void* src, void* dst, size_t size, const Context& ctx) {
+    Decrypt(src, dst, size, ctx, PolicyExecutor<std::decay_t<ExecutionPolicy>>(policy));
+}
+
+/**
+ * @brief Encrypt
+ * @param policy Standard execution policy, e.g. std::execution::par_unseq
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ */
+template<class ExecutionPolicy, class = Detail::IfExecutionPolicy<ExecutionPolicy>>
+inline void Encrypt(ExecutionPolicy&& policy, uchar* data, size_t size, const Context& ctx) {
+    Encrypt(std::forward<ExecutionPolicy>(policy), data, data, size, ctx);
+}
+
+/**
+ * @brief Decrypt
+ * @param policy Standard execution policy, e.g. std::execution::par_unseq
+ * @param data Pointer to the data that will be decrypted in place
+ * @param size Size of data provided, in bytes. Must be multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ */
+template<class ExecutionPolicy, class = Detail::IfExecutionPolicy<ExecutionPolicy>>
+inline void Decrypt(ExecutionPolicy&& policy, uchar* data, size_t size, const Context& ctx) {
+    Decrypt(std::forward<ExecutionPolicy>(policy), data, data, size, ctx);
+}
+
+/**
+ * @brief EncryptCtr
+ * @details Parallel variant on the standard parallel algorithms, see EncryptCtr
+ * @param policy Standard execution policy, e.g. std::execution::par_unseq
+ * @param data Pointer to the data that will be encrypted in place
+ * @param size Size of data provided, in bytes. Any size
+ * @param ctx Expanded key
+ * @param nonce Initial 64-bit counter
+ * @param offset Position of data in the stream, in bytes
+ */
+template<class ExecutionPolicy, class = Detail::IfExecutionPolicy<ExecutionPolicy>>
+inline void EncryptCtr(ExecutionPolicy&& policy, uchar* data, size_t size, const Context& ctx, uint64_t nonce, uint64_t offset = 0) {
+    EncryptCtr(data, size, ctx, nonce, offset, PolicyExecutor<std::decay_t<ExecutionPolicy>>(policy));
+}
+
+/**
+ * @brief DecryptCtr
+ * @details Same as EncryptCtr
+ */
+template<class ExecutionPolicy, class = Detail::IfExecutionPolicy<ExecutionPolicy>>
+inline void DecryptCtr(ExecutionPolicy&& policy, uchar* data, size_t size, const Context& ctx, uint64_t nonce, uint64_t offset = 0) {
+    EncryptCtr(std::forward<ExecutionPolicy>(policy), data, size, ctx, nonce, offset);
+}
+
+#endif /* ifdef(XTEA_HAS_EXECUTION) */
+
+#ifdef QT_CORE_LIB
+
+/**
+ * @brief Encrypt
+ * @param data Reference to data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param key Any bytearray of 128 bit long
+ * @param n_rounds Number of rounds. More rounds means
+ * better cryptographic strength and is therefore slower execution time
+ */
+inline void Encrypt(QByteArray& data, const QByteArray& key, uint n_rounds = 32) noexcept {
+    Encrypt((uchar*)data.data(), data.size(), (uchar*)key.constData(), n_rounds);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Reference to data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param key Any bytearray of 128 bit long which was used to encrypt
+ * @param n_rounds Number of rounds which was used to encrypt
+ */
+inline void Decrypt(QByteArray& data, const QByteArray& key, uint n_rounds = 32) noexcept {
+    Decrypt((uchar*)data.data(), data.size(), (uchar*)key.constData(), n_rounds);
+}
+
+/**
+ * @brief Encrypt
+ * @param data Reference to data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ */
+inline void Encrypt(QByteArray& data, const Context& ctx) noexcept {
+    Encrypt((uchar*)data.data(), data.size(), ctx);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Reference to data that will be decrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ */
+inline void Decrypt(QByteArray& data, const Context& ctx) noexcept {
+    Decrypt((uchar*)data.data(), data.size(), ctx);
+}
+
+/**
+ * @brief Encrypt
+ * @details XXTEA over the whole data as a single block
+ * @param data Reference to data that will be encrypted, size multiple of 4 and at least 8
+ * @param ctx Expanded XXTEA key
+ * @return false if the size of data is not a multiple of 4 or is less than 8
+ */
+inline bool Encrypt(QByteArray& data, const XxteaContext& ctx) noexcept {
+    return Encrypt(data.data(), data.size(), ctx);
+}
+
+/**
+ * @brief Decrypt
+ * @param data Reference to data that will be decrypted, size multiple of 4 and at least 8
+ * @param ctx Expanded XXTEA key which was used to encrypt
+ * @return false if the size of data is not a multiple of 4 or is less than 8
+ */
+inline bool Decrypt(QByteArray& data, const XxteaContext& ctx) noexcept {
+    return Decrypt(data.data(), data.size(), ctx);
+}
+
+/**
+ * @brief Encrypt
+ * @details Variant for any size; data is resized to the ciphertext size
+ * @param data Reference to data that will be encrypted
+ * @param ctx Expanded key
+ * @param tail Padding policy
+ * @return false if data is too small for Tail::Stealing
+ */
+inline bool Encrypt(QByteArray& data, const Context& ctx, Tail tail) {
+    const size_t size = data.size();
+    data.resize(EncryptedSize(size, tail));
+    return Encrypt(data.constData(), data.data(), size, ctx, tail);
+}
+
+/**
+ * @brief Decrypt
+ * @details Variant for any size; data is resized to the plaintext size
+ * @param data Reference to data that will be decrypted
+ * @param ctx Expanded key which was used to encrypt
+ * @param tail Padding policy which was used to encrypt
+ * @return false if the size or the padding is not valid
+ */
+inline bool Decrypt(QByteArray& data, const Context& ctx, Tail tail) {
+    size_t plain_size;
+    if (!Decrypt(data.data(), data.data(), data.size(), ctx, tail, plain_size)) return false;
+    data.resize(plain_size);
+    return true;
+}
+
+/**
+ * @brief Encrypt
+ * @details Out-of-place variant: dst is resized to the size of src and receives the ciphertext
+ * @param src Data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param dst Encrypted data
+ * @param key Any bytearray of 128 bit long
+ * @param n_rounds Number of rounds
+ */
+inline void Encrypt(const QByteArray& src, QByteArray& dst, const QByteArray& key, uint n_rounds = 32) {
+    dst.resize(src.size());
+    Encrypt(src.constData(), dst.data(), src.size(), (const uchar*)key.constData(), n_rounds);
+}
+
+/**
+ * @brief Decrypt
+ * @details Out-of-place variant: dst is resized to the size of src and receives the plaintext
+ * @param src Data that will be decrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param dst Decrypted data
+ * @param key Any bytearray of 128 bit long which was used to encrypt
+ * @param n_rounds Number of rounds which was used to encrypt
+ */
+inline void Decrypt(const QByteArray& src, QByteArray& dst, const QByteArray& key, uint n_rounds = 32) {
+    dst.resize(src.size());
+    Decrypt(src.constData(), dst.data(), src.size(), (const uchar*)key.constData(), n_rounds);
+}
+
+/**
+ * @brief Encrypt
+ * @param src Data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param dst Encrypted data, resized to the size of src
+ * @param ctx Expanded key
+ */
+inline void Encrypt(const QByteArray& src, QByteArray& dst, const Context& ctx) {
+    dst.resize(src.size());
+    Encrypt(src.constData(), dst.data(), src.size(), ctx);
+}
+
+/**
+ * @brief Decrypt
+ * @param src Data that will be decrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param dst Decrypted data, resized to the size of src
+ * @param ctx Expanded key which was used to encrypt
+ */
+inline void Decrypt(const QByteArray& src, QByteArray& dst, const Context& ctx) {
+    dst.resize(src.size());
+    Decrypt(src.constData(), dst.data(), src.size(), ctx);
+}
+
+/**
+ * @brief Encrypt
+ * @tparam Rounds Number of rounds, unrolled at compile time
+ * @param data Reference to data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param key Any bytearray of 128 bit long
+ */
+template<uint Rounds>
+inline void Encrypt(QByteArray& data, const QByteArray& key) noexcept {
+    Encrypt<Rounds>((uchar*)data.data(), data.size(), (uchar*)key.constData());
+}
+
+/**
+ * @brief Decrypt
+ * @tparam Rounds Number of rounds which was used to encrypt, unrolled at compile time
+ * @param data Reference to data that will be decrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param key Any bytearray of 128 bit long which was used to encrypt
+ */
+template<uint Rounds>
+inline void Decrypt(QByteArray& data, const QByteArray& key) noexcept {
+    Decrypt<Rounds>((uchar*)data.data(), data.size(), (uchar*)key.constData());
+}
+
+/**
+ * @brief EncryptCtr
+ * @param data Reference to data that will be encrypted in place, any size
+ * @param ctx Expanded key
+ * @param nonce Initial 64-bit counter
+ * @param offset Position of data in the stream, in bytes
+ */
+inline void EncryptCtr(QByteArray& data, const Context& ctx, uint64_t nonce, uint64_t offset = 0) {
+    EncryptCtr((uchar*)data.data(), data.size(), ctx, nonce, offset);
+}
+
+/**
+ * @brief DecryptCtr
+ * @details Same as EncryptCtr
+ */
+inline void DecryptCtr(QByteArray& data, const Context& ctx, uint64_t nonce, uint64_t offset = 0) {
+    EncryptCtr((uchar*)data.data(), data.size(), ctx, nonce, offset);
+}
+
+/**
+ * @brief EncryptCbc
+ * @param data Reference to data that will be encrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key
+ * @param iv Initialization vector of XTEA_BLOCK_SIZE bytes
+ */
+inline void EncryptCbc(QByteArray& data, const Context& ctx, const QByteArray& iv) noexcept {
+    EncryptCbc((uchar*)data.data(), data.size(), ctx, (const uchar*)iv.constData());
+}
+
+/**
+ * @brief DecryptCbc
+ * @param data Reference to data that will be decrypted with size multiple of XTEA_BLOCK_SIZE
+ * @param ctx Expanded key which was used to encrypt
+ * @param iv Initialization vector which was used to encrypt
+ * @param n_threads Number of threads to spread large buffers over, 0 for the hardware concurrency
+ */
+inline void DecryptCbc(QByteArray& data, const Context& ctx, const QByteArray& iv, uint n_threads = 1) {
+    DecryptCbc((uchar*)data.data(), data.size(), ctx, (const uchar*)iv.constData(), n_threads);
+}
+
+/**
+ * @brief EncryptCbcCs3
+ * @param data Reference to data that will be encrypted, at least XTEA_BLOCK_SIZE long
+ * @param ctx Expanded key
+ * @param iv Initialization vector of XTEA_BLOCK_SIZE bytes
+ * @return false if data is shorter than XTEA_BLOCK_SIZE
+ */
+inline bool EncryptCbcCs3(QByteArray& data, const Context& ctx, const QByteArray& iv) noexcept {
+    return EncryptCbcCs3((uchar*)data.data(), data.size(), ctx, (const uchar*)iv.constData());
+}
+
+/**
+ * @brief DecryptCbcCs3
+ * @param data Reference to data that will be decrypted, at least XTEA_BLOCK_SIZE long
+ * @param ctx Expanded key which was used to encrypt
+ * @param iv Initialization vector which was used to encrypt
+ * @param n_threads Number of threads to spread large buffers over, 0 for the hardware concurrency
+ * @return false if data is shorter than XTEA_BLOCK_SIZE
+ */
+inline bool DecryptCbcCs3(QByteArray& data, const Context& ctx, const QByteArray& iv, uint n_threads = 1) {
+    return DecryptCbcCs3((uchar*)data.data(), data.size(), ctx, (const uchar*)iv.constData(), n_threads);
 }
 
 #endif /* ifdef(QT_CORE_LIB) */